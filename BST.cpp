@@ -1,103 +1,138 @@
 #include "BST.h"
 
-BST::BST() : root(nullptr)
+BST::BST() : view(20.f, sf::Color::Green), layout(50.f, 100.f), scene(true), levelOfDetail(true)
 {
-    setupFont(); // Initialize font
+    FontCache::warmGlyphs(20); // Node labels use the shared font at size 20
 }
 
-BST::~BST()
+void BST::insert(int value)
 {
-    deleteTree(root); // Clean up tree memory
-}
+    Node *parent;
+    Node *node = tree.insert(value, &parent); // Insert the value into the tree
+    view.resize(tree.size());
 
-void BST::setupFont()
-{
-    if (!font.loadFromFile("Arial.ttf"))
-    { // Ensure the correct path to the font
-        std::cerr << "Error loading font!" << std::endl;
-        exit(EXIT_FAILURE); // Exit if font can't be loaded
-    }
+    layout.updateLinks(node);
+    if (parent)
+        layout.updateLinks(parent); // The parent gained a child
+    else
+        layout.setRoot(node->id);
+    scene.invalidate(); // The cached drawing no longer matches the tree
 }
 
-void BST::insert(int value)
+void BST::relinkAll()
 {
-    insertRecursive(root, value); // Insert the value into the tree
+    view.clear();
+    view.resize(tree.size());
+    layout.clear();
+    for (std::size_t id = 0; id < tree.size(); ++id)
+    {
+        layout.updateLinks(tree.getNode(static_cast<int>(id)));
+    }
+    layout.setRoot(tree.getRoot() ? tree.getRoot()->id : TreeLayout::None);
+    scene.invalidate();
 }
 
-void BST::insertRecursive(Node *&node, int value)
+void BST::visualize(sf::RenderTarget &target)
 {
-    if (!node)
+    if (tree.getRoot())
     {
-        node = new Node(value); // Create a new node if the current node is null
-    }
-    else if (value < node->value)
-    {
-        insertRecursive(node->left, value); // Insert to the left
-    }
-    else
-    {
-        insertRecursive(node->right, value); // Insert to the right
+        if (scene.needsRebuild(target))
+        {
+            layout.update();
+            BatchRenderer &batch = scene.rebuild(target);
+            sf::Vector2f origin(target.getSize().x / 2.f, 70.f); // Root centered at the top
+
+            // Only the nodes whose circle or edge reaches the visible area
+            sf::FloatRect area = scene.getVisibleArea();
+            area.left -= origin.x;
+            area.top -= origin.y;
+            float unitsPerPixel = area.width / target.getSize().x;
+
+            visibleIds.clear();
+            collapsedIds.clear();
+            if (levelOfDetail)
+                layout.queryDetail(area, collapseWidth * unitsPerPixel, visibleIds, collapsedIds);
+            else
+                layout.query(area, visibleIds);
+
+            for (int id : visibleIds)
+            {
+                visualizeNode(tree.getNode(id), batch, origin);
+            }
+            for (int id : collapsedIds)
+            {
+                visualizeSubtree(tree.getNode(id), batch, origin, unitsPerPixel);
+            }
+        }
+        scene.draw(target); // Visible part of the tree in a constant number of draw calls
     }
 }
 
-void BST::visualize(sf::RenderWindow &window)
+void BST::visualizeNode(Node *node, BatchRenderer &batch, sf::Vector2f origin)
 {
-    if (root)
+    sf::Vector2f center = origin + layout.getPosition(node->id);
+    batch.addCircle(center, view.getRadius(), view.getColor(node->id)); // Draw the node
+
+    // Display the value of the node at the center
+    batch.addText(std::to_string(node->value), FontCache::get(), 20, center - sf::Vector2f(10, 12), sf::Color::White);
+
+    // Each node draws the edge up to its parent, so every edge is drawn once
+    int parent = layout.getParent(node->id);
+    if (parent != TreeLayout::None)
     {
-        visualizeRecursive(root, window, 400.f, 50.f, 150.f); // Start visualizing from root
+        batch.addLine(origin + layout.getPosition(parent), center, sf::Color::White);
     }
 }
 
-void BST::visualizeRecursive(Node *node, sf::RenderWindow &window, float x, float y, float xOffset)
+// Draw a whole subtree as one triangle spanning its extent, labelled with its size and height
+void BST::visualizeSubtree(Node *node, BatchRenderer &batch, sf::Vector2f origin, float unitsPerPixel)
 {
-    if (!node)
-        return;
+    sf::Vector2f top = origin + layout.getPosition(node->id);
+    sf::FloatRect bounds = layout.getSubtreeBounds(node->id);
+    float bottom = origin.y + bounds.top + bounds.height;
+    float left = std::min(origin.x + bounds.left, top.x - view.getRadius());
+    float right = std::max(origin.x + bounds.left + bounds.width, top.x + view.getRadius());
 
-    node->shape.setPosition(x, y); // Set the position of the node
-    window.draw(node->shape);      // Draw the node
+    sf::Color color = view.getColor(node->id);
+    color.a = 160;
+    batch.addTriangle(top, sf::Vector2f(left, bottom), sf::Vector2f(right, bottom), color);
 
-    // Create and display the value of the node at the center
-    sf::Text valueText(std::to_string(node->value), font, 20);
-    valueText.setFillColor(sf::Color::White);
-    valueText.setPosition(x - 10, y - 10); // Position the text in the center of the node
-    window.draw(valueText);
-
-    // Visualize left child if it exists
-    if (node->left)
+    int parent = layout.getParent(node->id);
+    if (parent != TreeLayout::None)
     {
-        sf::VertexArray line(sf::Lines, 2);
-        line[0].position = node->shape.getPosition();
-        line[1].position = sf::Vector2f(x - xOffset, y + 100.f);
-        line[0].color = sf::Color::White;
-        line[1].color = sf::Color::White;
-        window.draw(line);
-        visualizeRecursive(node->left, window, x - xOffset, y + 100.f, xOffset / 2.f); // Recursively draw left child
+        batch.addLine(origin + layout.getPosition(parent), top, sf::Color::White);
     }
 
-    // Visualize right child if it exists
-    if (node->right)
-    {
-        sf::VertexArray line(sf::Lines, 2);
-        line[0].position = node->shape.getPosition();
-        line[1].position = sf::Vector2f(x + xOffset, y + 100.f);
-        line[0].color = sf::Color::White;
-        line[1].color = sf::Color::White;
-        window.draw(line);
-        visualizeRecursive(node->right, window, x + xOffset, y + 100.f, xOffset / 2.f); // Recursively draw right child
-    }
+    // Labels keep a fixed on-screen size whatever the zoom
+    sf::Vector2f labelPosition(top.x - 8.f * unitsPerPixel, top.y + 4.f * unitsPerPixel);
+    batch.addText(std::to_string(layout.getSubtreeSize(node->id)), FontCache::get(), 12,
+                  labelPosition, sf::Color::White, unitsPerPixel);
+    batch.addText("h" + std::to_string(layout.getSubtreeHeight(node->id)), FontCache::get(), 12,
+                  labelPosition + sf::Vector2f(0.f, 14.f * unitsPerPixel), sf::Color::White, unitsPerPixel);
 }
 
-void BST::deleteTree(Node *node)
+void BST::setLevelOfDetail(bool enabled)
 {
-    if (node)
-    {
-        deleteTree(node->left);  // Recursively delete left subtree
-        deleteTree(node->right); // Recursively delete right subtree
-        delete node;             // Delete the current node
-    }
+    levelOfDetail = enabled;
+    scene.invalidate();
 }
 
 BST::Node *BST::getRoot() const
 {
-    return root; // Return the root node
+    return tree.getRoot(); // Return the root node
+}
+
+BST::const_iterator BST::begin() const
+{
+    return tree.begin();
+}
+
+BST::const_iterator BST::end() const
+{
+    return tree.end();
+}
+
+IteratorRange<BST::const_iterator> BST::range(int lo, int hi) const
+{
+    return tree.range(lo, hi);
 }
@@ -0,0 +1,371 @@
+#ifndef BST_CORE_H
+#define BST_CORE_H
+
+#include <vector>
+#include <cstddef>
+#include <iterator>
+#include <thread>
+#include <algorithm>
+#include "IteratorRange.h"
+#include "NodePool.h"
+
+// Unbalanced binary search tree; BST keeps what it draws in per-id arrays.
+// Every walk is a loop, so a tree degenerated into a list works at any depth.
+class BSTCore
+{
+public:
+    struct Node
+    {
+        int value;
+        int id; // Insertion order, the key of the node's layout and view data
+        Node *left;
+        Node *right;
+
+        Node(int val, int nodeId) : value(val), id(nodeId), left(nullptr), right(nullptr) {}
+    };
+
+    // Bidirectional in-order iterator over the values. Nodes have no parent links,
+    // so the iterator keeps the path from the root down to its node: O(height)
+    // memory per iterator, however many values a walk visits.
+    class const_iterator
+    {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef int value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const int *pointer;
+        typedef const int &reference;
+
+        const_iterator() : root(nullptr) {}
+
+        reference operator*() const { return path.back()->value; }
+        pointer operator->() const { return &path.back()->value; }
+
+        const_iterator &operator++();
+        const_iterator operator++(int)
+        {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+        const_iterator &operator--();
+        const_iterator operator--(int)
+        {
+            const_iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator &other) const { return current() == other.current(); }
+        bool operator!=(const const_iterator &other) const { return current() != other.current(); }
+
+    private:
+        friend class BSTCore;
+        explicit const_iterator(Node *root) : root(root) {}
+
+        std::vector<Node *> path; // Root down to the current node; empty past the end
+        Node *root;               // Where end() steps back from
+
+        Node *current() const { return path.empty() ? nullptr : path.back(); }
+        void descend(Node *node, bool leftward); // Push node and its chain of left (or right) children
+    };
+    typedef const_iterator iterator;
+
+private:
+    static const std::size_t parallelThreshold = 1 << 18; // Smaller sorts stay on one thread
+
+    Node *root;
+    Node *smallest; // Leftmost and rightmost nodes, nullptr when empty
+    Node *largest;
+    NodePool<Node> pool;       // Storage of the nodes; clear() rewinds it in O(1)
+    std::vector<Node *> nodes; // Every node, indexed by id
+
+    const_iterator bound(int value, bool inclusive) const; // First value above (or not below) value
+    void linkBalanced();                           // Link the nodes, in id order, into a balanced tree
+    static void sortValues(std::vector<int> &values); // Sort, in parallel for large inputs
+
+public:
+    BSTCore();
+
+    BSTCore(const BSTCore &) = delete;
+    BSTCore &operator=(const BSTCore &) = delete;
+
+    // Insert a value (equal values go right) and return its new node. If parent is
+    // given, it receives the node the new one was attached to, or nullptr for the root.
+    Node *insert(int value, Node **parent = nullptr);
+
+    // Replace the contents with the values of [first, last), which must be in
+    // ascending order, as a balanced tree in O(n). Ids follow the value order.
+    template <typename InputIt>
+    void build_from_sorted(InputIt first, InputIt last)
+    {
+        clear();
+        for (; first != last; ++first)
+        {
+            nodes.push_back(pool.allocate(*first, static_cast<int>(nodes.size())));
+        }
+        linkBalanced();
+    }
+
+    // Same for values in any order, sorted first in O(n log n)
+    template <typename InputIt>
+    void build_from_unsorted(InputIt first, InputIt last)
+    {
+        std::vector<int> values(first, last);
+        sortValues(values);
+        build_from_sorted(values.begin(), values.end());
+    }
+
+    void clear(); // Remove every node at once, keeping the pool's blocks for new ones
+
+    Node *getRoot() const;
+    Node *getNode(int id) const;
+    std::size_t size() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    IteratorRange<const_iterator> range(int lo, int hi) const; // The values in [lo, hi], in order
+};
+
+// ------------------------------------------------------
+// Implementation of BSTCore methods
+
+BSTCore::BSTCore() : root(nullptr), smallest(nullptr), largest(nullptr)
+{
+}
+
+void BSTCore::clear()
+{
+    pool.clear(); // Nodes own nothing, so no traversal (and no recursion) is needed
+    nodes.clear();
+    root = nullptr;
+    smallest = nullptr;
+    largest = nullptr;
+}
+
+void BSTCore::linkBalanced()
+{
+    // Each range of ids hangs its middle node from the link it was pushed with; the
+    // stack holds at most one pending range per level, so it stays O(log n)
+    struct Range
+    {
+        std::size_t first;
+        std::size_t last; // One past the end
+        Node **link;
+    };
+
+    root = nullptr;
+    std::vector<Range> pending;
+    pending.push_back(Range{0, nodes.size(), &root});
+    while (!pending.empty())
+    {
+        Range range = pending.back();
+        pending.pop_back();
+        if (range.first == range.last)
+            continue;
+
+        std::size_t middle = range.first + (range.last - range.first) / 2;
+        Node *node = nodes[middle];
+        *range.link = node;
+        pending.push_back(Range{middle + 1, range.last, &node->right});
+        pending.push_back(Range{range.first, middle, &node->left});
+    }
+
+    // Ids follow the value order, so the ends of the tree are the ends of the table
+    smallest = nodes.empty() ? nullptr : nodes.front();
+    largest = nodes.empty() ? nullptr : nodes.back();
+}
+
+void BSTCore::sortValues(std::vector<int> &values)
+{
+    unsigned int threads = std::thread::hardware_concurrency();
+    if (values.size() < parallelThreshold || threads < 2)
+    {
+        std::sort(values.begin(), values.end());
+        return;
+    }
+
+    // One run per thread, then merge neighbouring runs pairwise, each round's merges
+    // on separate threads
+    std::vector<std::size_t> bounds;
+    for (unsigned int run = 0; run <= threads; ++run)
+    {
+        bounds.push_back(values.size() * run / threads);
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned int run = 0; run < threads; ++run)
+    {
+        workers.emplace_back([&values, &bounds, run]() {
+            std::sort(values.begin() + bounds[run], values.begin() + bounds[run + 1]);
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    for (unsigned int width = 1; width < threads; width *= 2)
+    {
+        workers.clear();
+        for (unsigned int run = 0; run + width < threads; run += 2 * width)
+        {
+            std::size_t first = bounds[run];
+            std::size_t middle = bounds[run + width];
+            std::size_t last = bounds[std::min(run + 2 * width, threads)];
+            workers.emplace_back([&values, first, middle, last]() {
+                std::inplace_merge(values.begin() + first, values.begin() + middle, values.begin() + last);
+            });
+        }
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+}
+
+BSTCore::Node *BSTCore::insert(int value, Node **parent)
+{
+    Node *above = nullptr;
+    Node **link = &root;
+    if (largest && value >= largest->value)
+    {
+        above = largest; // Every node on the way would have sent the value right
+        link = &largest->right;
+    }
+    else if (smallest && value < smallest->value)
+    {
+        above = smallest;
+        link = &smallest->left;
+    }
+    else
+    {
+        while (*link)
+        {
+            above = *link;
+            link = value < above->value ? &above->left : &above->right;
+        }
+    }
+
+    *link = pool.allocate(value, static_cast<int>(nodes.size()));
+    nodes.push_back(*link);
+    if (!largest || value >= largest->value)
+        largest = *link;
+    if (!smallest || value < smallest->value)
+        smallest = *link;
+    if (parent)
+        *parent = above;
+    return *link;
+}
+
+BSTCore::Node *BSTCore::getRoot() const
+{
+    return root;
+}
+
+BSTCore::Node *BSTCore::getNode(int id) const
+{
+    return nodes[id];
+}
+
+std::size_t BSTCore::size() const
+{
+    return nodes.size();
+}
+
+BSTCore::const_iterator BSTCore::begin() const
+{
+    const_iterator it(root);
+    it.descend(root, true);
+    return it;
+}
+
+BSTCore::const_iterator BSTCore::end() const
+{
+    return const_iterator(root);
+}
+
+BSTCore::const_iterator BSTCore::bound(int value, bool inclusive) const
+{
+    // Keep the search path, cut back to the last node that qualified
+    const_iterator it(root);
+    std::size_t found = 0;
+    for (Node *node = root; node;)
+    {
+        it.path.push_back(node);
+        if (node->value > value || (inclusive && node->value == value))
+        {
+            found = it.path.size();
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+    it.path.resize(found);
+    return it;
+}
+
+IteratorRange<BSTCore::const_iterator> BSTCore::range(int lo, int hi) const
+{
+    if (lo > hi)
+        return IteratorRange<const_iterator>(end(), end());
+    return IteratorRange<const_iterator>(bound(lo, true), bound(hi, false));
+}
+
+// ------------------------------------------------------
+// Implementation of BSTCore::const_iterator methods
+
+void BSTCore::const_iterator::descend(Node *node, bool leftward)
+{
+    for (; node; node = leftward ? node->left : node->right)
+    {
+        path.push_back(node);
+    }
+}
+
+BSTCore::const_iterator &BSTCore::const_iterator::operator++()
+{
+    Node *node = path.back();
+    if (node->right)
+    {
+        descend(node->right, true);
+        return *this;
+    }
+
+    // Climb past every ancestor whose right subtree we just finished
+    path.pop_back();
+    while (!path.empty() && path.back()->right == node)
+    {
+        node = path.back();
+        path.pop_back();
+    }
+    return *this;
+}
+
+BSTCore::const_iterator &BSTCore::const_iterator::operator--()
+{
+    if (path.empty())
+    {
+        descend(root, false); // end() steps back to the largest value
+        return *this;
+    }
+
+    Node *node = path.back();
+    if (node->left)
+    {
+        descend(node->left, false);
+        return *this;
+    }
+
+    path.pop_back();
+    while (!path.empty() && path.back()->left == node)
+    {
+        node = path.back();
+        path.pop_back();
+    }
+    return *this;
+}
+
+#endif // BST_CORE_H
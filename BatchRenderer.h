@@ -0,0 +1,194 @@
+#ifndef BATCH_RENDERER_H
+#define BATCH_RENDERER_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <cmath>
+
+// Collects every shape, edge and label of a structure into a few vertex arrays
+// so that drawing it costs the same handful of draw calls at any size.
+class BatchRenderer
+{
+private:
+    // Labels are grouped per font and character size, since each pair has its own glyph texture
+    struct LabelBatch
+    {
+        const sf::Font *font;
+        unsigned int characterSize;
+        sf::VertexArray vertices;
+
+        LabelBatch(const sf::Font &f, unsigned int size)
+            : font(&f), characterSize(size), vertices(sf::Triangles) {}
+    };
+
+    static const int circleSegments = 30; // Same point count as sf::CircleShape
+
+    sf::VertexArray shapes;          // Circles and rectangles as triangles
+    sf::VertexArray edges;           // Connections between nodes as lines
+    std::vector<LabelBatch> labels;  // Glyph quads as triangles, one array per glyph texture
+
+    LabelBatch &labelBatch(const sf::Font &font, unsigned int characterSize);
+
+public:
+    BatchRenderer();
+
+    void clear(); // Drop all geometry but keep the allocated vertex storage
+
+    void addCircle(sf::Vector2f center, float radius, sf::Color color);
+    void addRectangle(sf::Vector2f position, sf::Vector2f size, sf::Color color);
+    void addTriangle(sf::Vector2f a, sf::Vector2f b, sf::Vector2f c, sf::Color color);
+    void addLine(sf::Vector2f from, sf::Vector2f to, sf::Color color);
+
+    // Text is rasterized at characterSize and drawn scale times as large, which keeps
+    // labels readable at a fixed on-screen size while zoomed out
+    void addText(const std::string &text, const sf::Font &font, unsigned int characterSize,
+                 sf::Vector2f position, sf::Color color, float scale = 1.f);
+
+    void draw(sf::RenderTarget &target) const; // Submit everything in 2 + (number of glyph textures) calls
+    std::size_t getVertexCount() const;
+};
+
+// ------------------------------------------------------
+// Implementation of BatchRenderer methods
+
+BatchRenderer::BatchRenderer() : shapes(sf::Triangles), edges(sf::Lines) {}
+
+void BatchRenderer::clear()
+{
+    shapes.clear();
+    edges.clear();
+    for (auto &batch : labels)
+    {
+        batch.vertices.clear();
+    }
+}
+
+BatchRenderer::LabelBatch &BatchRenderer::labelBatch(const sf::Font &font, unsigned int characterSize)
+{
+    for (auto &batch : labels)
+    {
+        if (batch.font == &font && batch.characterSize == characterSize)
+            return batch;
+    }
+    labels.emplace_back(font, characterSize);
+    return labels.back();
+}
+
+// Add a filled circle as a fan of triangles around its center
+void BatchRenderer::addCircle(sf::Vector2f center, float radius, sf::Color color)
+{
+    // Unit circle points are computed once and shared by every circle
+    static std::vector<sf::Vector2f> unitCircle;
+    if (unitCircle.empty())
+    {
+        for (int i = 0; i <= circleSegments; ++i)
+        {
+            float angle = i * 2.f * 3.14159265f / circleSegments;
+            unitCircle.push_back(sf::Vector2f(std::cos(angle), std::sin(angle)));
+        }
+    }
+
+    for (int i = 0; i < circleSegments; ++i)
+    {
+        shapes.append(sf::Vertex(center, color));
+        shapes.append(sf::Vertex(center + unitCircle[i] * radius, color));
+        shapes.append(sf::Vertex(center + unitCircle[i + 1] * radius, color));
+    }
+}
+
+// Add an axis-aligned filled rectangle as two triangles
+void BatchRenderer::addRectangle(sf::Vector2f position, sf::Vector2f size, sf::Color color)
+{
+    sf::Vector2f topRight(position.x + size.x, position.y);
+    sf::Vector2f bottomLeft(position.x, position.y + size.y);
+    sf::Vector2f bottomRight(position.x + size.x, position.y + size.y);
+
+    shapes.append(sf::Vertex(position, color));
+    shapes.append(sf::Vertex(topRight, color));
+    shapes.append(sf::Vertex(bottomLeft, color));
+    shapes.append(sf::Vertex(bottomLeft, color));
+    shapes.append(sf::Vertex(topRight, color));
+    shapes.append(sf::Vertex(bottomRight, color));
+}
+
+void BatchRenderer::addTriangle(sf::Vector2f a, sf::Vector2f b, sf::Vector2f c, sf::Color color)
+{
+    shapes.append(sf::Vertex(a, color));
+    shapes.append(sf::Vertex(b, color));
+    shapes.append(sf::Vertex(c, color));
+}
+
+void BatchRenderer::addLine(sf::Vector2f from, sf::Vector2f to, sf::Color color)
+{
+    edges.append(sf::Vertex(from, color));
+    edges.append(sf::Vertex(to, color));
+}
+
+// Lay out a single line of text the same way sf::Text does, one textured quad per glyph
+void BatchRenderer::addText(const std::string &text, const sf::Font &font, unsigned int characterSize,
+                            sf::Vector2f position, sf::Color color, float scale)
+{
+    sf::VertexArray &vertices = labelBatch(font, characterSize).vertices;
+
+    float x = position.x;
+    float y = position.y + characterSize * scale; // sf::Text puts the baseline one character size below the top
+    sf::Uint32 previous = 0;
+
+    for (char c : text)
+    {
+        sf::Uint32 current = static_cast<unsigned char>(c);
+        x += font.getKerning(previous, current, characterSize) * scale;
+        previous = current;
+
+        const sf::Glyph &glyph = font.getGlyph(current, characterSize, false);
+
+        float left = x + glyph.bounds.left * scale;
+        float top = y + glyph.bounds.top * scale;
+        float right = left + glyph.bounds.width * scale;
+        float bottom = top + glyph.bounds.height * scale;
+
+        float u1 = static_cast<float>(glyph.textureRect.left);
+        float v1 = static_cast<float>(glyph.textureRect.top);
+        float u2 = u1 + glyph.textureRect.width;
+        float v2 = v1 + glyph.textureRect.height;
+
+        vertices.append(sf::Vertex(sf::Vector2f(left, top), color, sf::Vector2f(u1, v1)));
+        vertices.append(sf::Vertex(sf::Vector2f(right, top), color, sf::Vector2f(u2, v1)));
+        vertices.append(sf::Vertex(sf::Vector2f(left, bottom), color, sf::Vector2f(u1, v2)));
+        vertices.append(sf::Vertex(sf::Vector2f(left, bottom), color, sf::Vector2f(u1, v2)));
+        vertices.append(sf::Vertex(sf::Vector2f(right, top), color, sf::Vector2f(u2, v1)));
+        vertices.append(sf::Vertex(sf::Vector2f(right, bottom), color, sf::Vector2f(u2, v2)));
+
+        x += glyph.advance * scale;
+    }
+}
+
+void BatchRenderer::draw(sf::RenderTarget &target) const
+{
+    if (edges.getVertexCount() > 0)
+        target.draw(edges);
+    if (shapes.getVertexCount() > 0)
+        target.draw(shapes);
+
+    for (const auto &batch : labels)
+    {
+        if (batch.vertices.getVertexCount() > 0)
+        {
+            // Fetch the texture at draw time: requesting glyphs may have grown the font's page
+            target.draw(batch.vertices, &batch.font->getTexture(batch.characterSize));
+        }
+    }
+}
+
+std::size_t BatchRenderer::getVertexCount() const
+{
+    std::size_t count = shapes.getVertexCount() + edges.getVertexCount();
+    for (const auto &batch : labels)
+    {
+        count += batch.vertices.getVertexCount();
+    }
+    return count;
+}
+
+#endif // BATCH_RENDERER_H
@@ -0,0 +1,589 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <queue>
+#include <utility>
+#include "HeapCore.h"
+#include "QueueCore.h"
+#include "ConcurrentStack.h"
+#include "IndexedHeapCore.h"
+#include "PairingHeapCore.h"
+#include "RadixHeapCore.h"
+#include "BSTCore.h"
+
+// Throughput of the SFML-free structure cores, run with final --bench <name> [--count N].
+// Inputs come from a fixed seed, so runs are comparable from one build to the next.
+class Benchmark
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static volatile long long sink;
+
+    static double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    static void report(const std::string &what, std::size_t operations, double seconds)
+    {
+        std::printf("  %-24s %10.2f ms %10.2f M ops/s\n", what.c_str(), seconds * 1000.0,
+                    seconds > 0 ? operations / seconds / 1e6 : 0.0);
+    }
+
+    static std::vector<int> randomValues(std::size_t count)
+    {
+        std::mt19937 random(42);
+        std::vector<int> values(count);
+        for (int &value : values)
+        {
+            value = static_cast<int>(random() >> 1);
+        }
+        return values;
+    }
+
+    // The baseline the concurrent stack is measured against
+    class MutexStack
+    {
+    private:
+        std::mutex mutex;
+        std::vector<int> values;
+
+    public:
+        void push(int value)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            values.push_back(value);
+        }
+
+        bool pop(int &value)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (values.empty())
+                return false;
+            value = values.back();
+            values.pop_back();
+            return true;
+        }
+    };
+
+    // Run operations split over threads, each alternating a push and a pop, and check
+    // that every pushed value is either popped or still on the stack afterwards
+    template <typename StackT>
+    static bool stackThreads(StackT &stack, int threads, std::size_t operations, double &seconds)
+    {
+        std::atomic<long long> pushed(0);
+        std::atomic<long long> popped(0);
+        std::atomic<bool> go(false);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]() {
+                long long pushedSum = 0;
+                long long poppedSum = 0;
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+
+                for (std::size_t i = t; i < operations; i += 2 * threads)
+                {
+                    int value = static_cast<int>(i);
+                    stack.push(value);
+                    pushedSum += value;
+                    if (stack.pop(value))
+                        poppedSum += value;
+                }
+                pushed += pushedSum;
+                popped += poppedSum;
+            });
+        }
+
+        Clock::time_point start = Clock::now();
+        go.store(true, std::memory_order_release);
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+        seconds = secondsSince(start);
+
+        long long remaining = 0;
+        int value;
+        while (stack.pop(value))
+        {
+            remaining += value;
+        }
+        return pushed.load() == popped.load() + remaining;
+    }
+
+    template <int Arity>
+    static bool heapArity(const std::vector<int> &values)
+    {
+        std::printf("%d-ary heap, %zu keys\n", Arity, values.size());
+        HeapCore<Arity> heap;
+        heap.reserve(values.size());
+
+        Clock::time_point start = Clock::now();
+        for (int value : values)
+        {
+            heap.push(value);
+        }
+        report("push", values.size(), secondsSince(start));
+
+        start = Clock::now();
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            sink = heap.top(); // A volatile store per read, so the loop is not folded away
+        }
+        report("top", values.size(), secondsSince(start));
+
+        // Popping must give the keys in non-increasing order
+        bool sorted = true;
+        int previous = heap.empty() ? 0 : heap.top();
+        start = Clock::now();
+        while (!heap.empty())
+        {
+            sorted = sorted && heap.top() <= previous;
+            previous = heap.top();
+            heap.pop();
+        }
+        report("pop", values.size(), secondsSince(start));
+
+        // Bulk load, then take the top 1% in one batch
+        start = Clock::now();
+        heap.build(values.begin(), values.end());
+        report("build (Floyd)", values.size(), secondsSince(start));
+
+        std::vector<int> peeked;
+        std::size_t k = values.size() / 100;
+        start = Clock::now();
+        heap.top_k(k, peeked);
+        report("top_k(" + std::to_string(k) + ")", k, secondsSince(start));
+
+        std::vector<int> largest;
+        start = Clock::now();
+        heap.pop_k(k, largest);
+        report("pop_k(" + std::to_string(k) + ")", k, secondsSince(start));
+
+        // The same batch as k single pops, for comparison
+        HeapCore<Arity> popped;
+        popped.build(values.begin(), values.end());
+        std::vector<int> oneByOne;
+        start = Clock::now();
+        for (std::size_t i = 0; i < k; ++i)
+        {
+            oneByOne.push_back(popped.top());
+            popped.pop();
+        }
+        report("pop x " + std::to_string(k), k, secondsSince(start));
+
+        std::vector<int> expected(k);
+        std::partial_sort_copy(values.begin(), values.end(), expected.begin(), expected.end(), std::greater<int>());
+        sorted = sorted && peeked == expected && largest == expected && oneByOne == expected && heap.size() == values.size() - k;
+
+        if (!sorted)
+            std::printf("  keys came out of order\n");
+        return sorted;
+    }
+
+public:
+    // Push, top and pop throughput of HeapCore at every supported arity
+    static bool heap(std::size_t count)
+    {
+        std::vector<int> values = randomValues(count);
+        bool ok = heapArity<2>(values);
+        ok = heapArity<4>(values) && ok;
+        ok = heapArity<8>(values) && ok;
+        return ok;
+    }
+
+    // Fill and drain QueueCore at growing sizes, one element and one batch at a time.
+    // The time per element should stay flat as the queue grows.
+    static bool queue(std::size_t count)
+    {
+        std::vector<int> values = randomValues(count);
+        std::vector<int> drained(count);
+        bool ok = true;
+        for (std::size_t size = std::max<std::size_t>(count / 64, 1); size <= count; size *= 4)
+        {
+            std::printf("queue of %zu\n", size);
+            QueueCore queue;
+
+            Clock::time_point start = Clock::now();
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                queue.push(values[i]);
+            }
+            report("enqueue", size, secondsSince(start));
+
+            start = Clock::now();
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                drained[i] = queue.front();
+                queue.pop();
+            }
+            report("dequeue", size, secondsSince(start));
+            ok = ok && std::equal(drained.begin(), drained.begin() + size, values.begin());
+
+            // Batches of 256 through a queue that wraps around the whole time
+            const std::size_t batch = 256;
+            start = Clock::now();
+            for (std::size_t i = 0; i < size; i += batch)
+            {
+                std::size_t n = std::min(batch, size - i);
+                queue.push_range(&values[i], n);
+                queue.pop_n(&drained[i], n);
+            }
+            report("enqueue_range/dequeue_n", size, secondsSince(start));
+            ok = ok && std::equal(drained.begin(), drained.begin() + size, values.begin());
+        }
+
+        if (!ok)
+            std::printf("  values came out of order\n");
+        return ok;
+    }
+
+    // Push/pop throughput of ConcurrentStack and a mutex-guarded vector at 1 to 32 threads
+    static bool stack(std::size_t count)
+    {
+        std::printf("%zu operations, half pushes and half pops (%u hardware threads)\n", count,
+                    std::thread::hardware_concurrency());
+        bool ok = true;
+        for (int threads = 1; threads <= 32; threads *= 2)
+        {
+            std::printf("%d thread%s\n", threads, threads == 1 ? "" : "s");
+            double seconds;
+
+            ConcurrentStack lockFree;
+            for (int i = 0; i < 1024; ++i)
+            {
+                lockFree.push(0); // Start non-empty, so pops rarely find it empty; zeros keep the sums intact
+            }
+            bool consistent = stackThreads(lockFree, threads, count, seconds);
+            report("lock-free", count, seconds);
+
+            MutexStack locked;
+            for (int i = 0; i < 1024; ++i)
+            {
+                locked.push(0);
+            }
+            consistent = stackThreads(locked, threads, count, seconds) && consistent;
+            report("mutex", count, seconds);
+
+            if (!consistent)
+                std::printf("  pushed and popped values do not add up\n");
+            ok = ok && consistent;
+        }
+        return ok;
+    }
+
+    // Priority updates through IndexedHeapCore against the lazy-deletion workaround:
+    // count/10 elements, count random updates, then a full drain
+    static bool indexedHeap(std::size_t count)
+    {
+        std::size_t elements = std::max<std::size_t>(count / 10, 1);
+        std::vector<int> values = randomValues(elements + count);
+        std::mt19937 random(7);
+        std::vector<std::size_t> targets(count);
+        for (std::size_t &target : targets)
+        {
+            target = random() % elements;
+        }
+        std::printf("%zu elements, %zu priority updates\n", elements, count);
+
+        // Indexed: update re-sifts the element where it is
+        IndexedHeapCore<> indexed;
+        std::vector<IndexedHeapCore<>::Handle> handles(elements);
+        std::vector<int> indexedOrder;
+        Clock::time_point start = Clock::now();
+        for (std::size_t i = 0; i < elements; ++i)
+        {
+            handles[i] = indexed.enqueue(values[i]);
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            indexed.update(handles[targets[i]], values[elements + i]);
+        }
+        std::size_t indexedPeak = indexed.size();
+        while (!indexed.empty())
+        {
+            indexedOrder.push_back(indexed.topPriority());
+            indexed.pop();
+        }
+        report("indexed update", count, secondsSince(start));
+        std::printf("  %-24s %10zu entries\n", "peak size", indexedPeak);
+
+        // Lazy deletion: push a new entry per update and skip outdated ones when popping
+        std::priority_queue<std::pair<int, std::size_t>> lazy;
+        std::vector<int> current(values.begin(), values.begin() + elements);
+        std::vector<int> lazyOrder;
+        start = Clock::now();
+        for (std::size_t i = 0; i < elements; ++i)
+        {
+            lazy.push(std::make_pair(values[i], i));
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            current[targets[i]] = values[elements + i];
+            lazy.push(std::make_pair(values[elements + i], targets[i]));
+        }
+        std::size_t lazyPeak = lazy.size();
+        std::vector<bool> done(elements, false);
+        while (!lazy.empty())
+        {
+            std::pair<int, std::size_t> entry = lazy.top();
+            lazy.pop();
+            if (done[entry.second] || entry.first != current[entry.second])
+                continue; // Outdated entry
+            done[entry.second] = true;
+            lazyOrder.push_back(entry.first);
+        }
+        report("lazy deletion", count, secondsSince(start));
+        std::printf("  %-24s %10zu entries\n", "peak size", lazyPeak);
+
+        bool ok = indexedOrder == lazyOrder;
+        if (!ok)
+            std::printf("  the two queues drained in different orders\n");
+        return ok;
+    }
+
+    // Push/pop throughput of PairingHeapCore against the binary HeapCore, then merging
+    // count values spread over several per-worker heaps into one
+    static bool pairing(std::size_t count)
+    {
+        const std::size_t workers = 8;
+        std::vector<int> values = randomValues(count);
+        bool ok = true;
+        std::printf("%zu keys\n", count);
+
+        HeapCore<2> array;
+        Clock::time_point start = Clock::now();
+        for (int value : values)
+        {
+            array.push(value);
+        }
+        report("binary push", count, secondsSince(start));
+
+        PairingHeapCore pairing;
+        start = Clock::now();
+        for (int value : values)
+        {
+            pairing.push(value);
+        }
+        report("pairing push", count, secondsSince(start));
+
+        std::vector<int> arrayOrder;
+        std::vector<int> pairingOrder;
+        start = Clock::now();
+        while (!array.empty())
+        {
+            arrayOrder.push_back(array.top());
+            array.pop();
+        }
+        report("binary pop", count, secondsSince(start));
+
+        start = Clock::now();
+        while (!pairing.empty())
+        {
+            pairingOrder.push_back(pairing.top());
+            pairing.pop();
+        }
+        report("pairing pop", count, secondsSince(start));
+        ok = ok && arrayOrder == pairingOrder;
+
+        // Merge: each worker heap holds every workers-th value
+        std::printf("merging %zu worker heaps\n", workers);
+        std::vector<HeapCore<2>> arrayWorkers(workers);
+        std::vector<PairingHeapCore> pairingWorkers(workers);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            arrayWorkers[i % workers].push(values[i]);
+            pairingWorkers[i % workers].push(values[i]);
+        }
+
+        HeapCore<2> pushed;
+        start = Clock::now();
+        for (HeapCore<2> &worker : arrayWorkers)
+        {
+            for (std::size_t i = 0; i < worker.size(); ++i)
+            {
+                pushed.push(worker[i]);
+            }
+        }
+        report("binary re-push", count, secondsSince(start));
+
+        HeapCore<2> rebuilt;
+        std::vector<int> batch;
+        start = Clock::now();
+        for (HeapCore<2> &worker : arrayWorkers)
+        {
+            for (std::size_t i = 0; i < worker.size(); ++i)
+            {
+                batch.push_back(worker[i]);
+            }
+        }
+        rebuilt.build(batch.begin(), batch.end());
+        report("binary rebuild", count, secondsSince(start));
+
+        PairingHeapCore melded;
+        start = Clock::now();
+        for (PairingHeapCore &worker : pairingWorkers)
+        {
+            melded.meld(worker);
+        }
+        report("pairing meld", count, secondsSince(start));
+
+        // All three hold the same keys
+        std::vector<int> top;
+        std::vector<int> expected(arrayOrder.begin(), arrayOrder.begin() + std::min<std::size_t>(100, count));
+        pushed.top_k(100, top);
+        ok = ok && top == expected;
+        top.clear();
+        rebuilt.top_k(100, top);
+        ok = ok && top == expected;
+        top.clear();
+        melded.pop_k(count, top);
+        ok = ok && top == arrayOrder;
+
+        if (!ok)
+            std::printf("  the heaps disagree on the order of the keys\n");
+        return ok;
+    }
+
+    // Monotone workload on a queue of count/10 events: every step pops the next event
+    // and schedules a new one at most 1000 ticks later. Time counts down, so the
+    // max-heaps pop it in order. The popped times go to order.
+    template <typename HeapT>
+    static double eventLoop(HeapT &heap, const std::vector<int> &values, std::size_t count, std::vector<int> &order)
+    {
+        std::size_t events = std::max<std::size_t>(count / 10, 1);
+        Clock::time_point start = Clock::now();
+        for (std::size_t i = 0; i < events; ++i)
+        {
+            heap.push(-(values[i] % 1000000));
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            int now = heap.top();
+            heap.pop();
+            order.push_back(now);
+            heap.push(now - values[i] % 1000);
+        }
+        return secondsSince(start);
+    }
+
+    // Pushes count keys in ascending order, timed, then drains the heap into order
+    template <typename HeapT>
+    static double ascendingLoad(HeapT &heap, std::size_t count, std::vector<int> &order)
+    {
+        Clock::time_point start = Clock::now();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            heap.push(static_cast<int>(i));
+        }
+        double seconds = secondsSince(start);
+        while (!heap.empty())
+        {
+            order.push_back(heap.top());
+            heap.pop();
+        }
+        return seconds;
+    }
+
+    // The event loop on RadixHeapCore against the binary HeapCore
+    static bool radix(std::size_t count)
+    {
+        std::vector<int> values = randomValues(count);
+        std::printf("%zu events, %zu steps\n", std::max<std::size_t>(count / 10, 1), count);
+
+        HeapCore<2> array;
+        std::vector<int> arrayOrder;
+        report("binary pop+push", count, eventLoop(array, values, count, arrayOrder));
+
+        RadixHeapCore radixHeap;
+        std::vector<int> radixOrder;
+        report("radix pop+push", count, eventLoop(radixHeap, values, count, radixOrder));
+
+        // Ascending pushes before any pop are monotone too, and must stay O(1) each
+        HeapCore<2> ascendingArray;
+        std::vector<int> ascendingArrayOrder;
+        report("binary ascending push", count, ascendingLoad(ascendingArray, count, ascendingArrayOrder));
+
+        RadixHeapCore ascendingRadix;
+        std::vector<int> ascendingRadixOrder;
+        report("radix ascending push", count, ascendingLoad(ascendingRadix, count, ascendingRadixOrder));
+
+        bool ok = arrayOrder == radixOrder && ascendingArrayOrder == ascendingRadixOrder;
+        if (!ok)
+            std::printf("  the heaps popped the events in different orders\n");
+        return ok;
+    }
+
+    // Bulk loads of BSTCore against one insert per value. Sorted input would turn the
+    // inserts into a list, so they only get the values in random order.
+    static bool bstLoad(std::size_t count)
+    {
+        std::vector<int> values = randomValues(count);
+        std::vector<int> sorted(values);
+        std::sort(sorted.begin(), sorted.end());
+
+        BSTCore inserted;
+        Clock::time_point start = Clock::now();
+        for (int value : values)
+        {
+            inserted.insert(value);
+        }
+        report("insert (random order)", count, secondsSince(start));
+
+        BSTCore unsorted;
+        start = Clock::now();
+        unsorted.build_from_unsorted(values.begin(), values.end());
+        report("build_from_unsorted", count, secondsSince(start));
+
+        BSTCore bulk;
+        start = Clock::now();
+        bulk.build_from_sorted(sorted.begin(), sorted.end());
+        report("build_from_sorted", count, secondsSince(start));
+
+        bool ok = std::equal(inserted.begin(), inserted.end(), sorted.begin()) &&
+                  std::equal(unsorted.begin(), unsorted.end(), sorted.begin()) &&
+                  std::equal(bulk.begin(), bulk.end(), sorted.begin());
+        if (!ok)
+            std::printf("  the trees disagree on the order of the values\n");
+        return ok;
+    }
+
+    // Run the named benchmark; false if it failed or does not exist
+    static bool run(const std::string &name, std::size_t count)
+    {
+        if (name == "heap")
+            return heap(count);
+        if (name == "queue")
+            return queue(count);
+        if (name == "stack")
+            return stack(count);
+        if (name == "ipq")
+            return indexedHeap(count);
+        if (name == "pairing")
+            return pairing(count);
+        if (name == "radix")
+            return radix(count);
+        if (name == "bstload")
+            return bstLoad(count);
+
+        std::printf("Unknown benchmark %s, expected heap, queue, stack, ipq, pairing, radix or bstload\n", name.c_str());
+        return false;
+    }
+};
+
+volatile long long Benchmark::sink = 0;
+
+#endif // BENCHMARK_H
@@ -0,0 +1,124 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+
+// Pan and zoom over a structure's world coordinates through an sf::View:
+// drag to pan, wheel or +/- to zoom around the cursor, Home to reset.
+class Camera
+{
+private:
+    sf::View view;
+    sf::Vector2u windowSize;
+    float zoomLevel; // World units per pixel
+    bool dragging;
+    sf::Vector2i lastMouse;
+
+    void zoomAt(sf::Vector2i pixel, float factor, const sf::RenderWindow &window);
+
+public:
+    explicit Camera(sf::Vector2u size);
+
+    void reset(); // Back to one world unit per pixel, showing the top-left of the world
+    bool handleEvent(const sf::Event &event, const sf::RenderWindow &window); // True if the view changed
+    const sf::View &getView() const;
+
+    static sf::FloatRect visibleArea(const sf::View &view); // World rectangle a view shows
+};
+
+// ------------------------------------------------------
+// Implementation of Camera methods
+
+Camera::Camera(sf::Vector2u size) : windowSize(size), zoomLevel(1.f), dragging(false)
+{
+    reset();
+}
+
+void Camera::reset()
+{
+    zoomLevel = 1.f;
+    view.reset(sf::FloatRect(0.f, 0.f, static_cast<float>(windowSize.x), static_cast<float>(windowSize.y)));
+}
+
+// Zoom while keeping the world point under the cursor in place
+void Camera::zoomAt(sf::Vector2i pixel, float factor, const sf::RenderWindow &window)
+{
+    float newZoom = std::min(std::max(zoomLevel * factor, 0.05f), 1000000.f);
+    factor = newZoom / zoomLevel;
+    zoomLevel = newZoom;
+
+    sf::Vector2f before = window.mapPixelToCoords(pixel, view);
+    view.zoom(factor);
+    sf::Vector2f after = window.mapPixelToCoords(pixel, view);
+    view.move(before - after);
+}
+
+bool Camera::handleEvent(const sf::Event &event, const sf::RenderWindow &window)
+{
+    switch (event.type)
+    {
+    case sf::Event::Resized:
+        windowSize = sf::Vector2u(event.size.width, event.size.height);
+        view.setSize(event.size.width * zoomLevel, event.size.height * zoomLevel);
+        return true;
+    case sf::Event::MouseWheelScrolled:
+        if (event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel)
+        {
+            float factor = event.mouseWheelScroll.delta > 0 ? 0.8f : 1.25f;
+            zoomAt(sf::Vector2i(event.mouseWheelScroll.x, event.mouseWheelScroll.y), factor, window);
+            return true;
+        }
+        break;
+    case sf::Event::MouseButtonPressed:
+        if (event.mouseButton.button == sf::Mouse::Left)
+        {
+            dragging = true;
+            lastMouse = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+        }
+        break;
+    case sf::Event::MouseButtonReleased:
+        if (event.mouseButton.button == sf::Mouse::Left)
+            dragging = false;
+        break;
+    case sf::Event::MouseMoved:
+        if (dragging)
+        {
+            sf::Vector2i mouse(event.mouseMove.x, event.mouseMove.y);
+            view.move(window.mapPixelToCoords(lastMouse, view) - window.mapPixelToCoords(mouse, view));
+            lastMouse = mouse;
+            return true;
+        }
+        break;
+    case sf::Event::KeyPressed:
+    {
+        sf::Vector2i center(windowSize.x / 2, windowSize.y / 2);
+        if (event.key.code == sf::Keyboard::Add || event.key.code == sf::Keyboard::Equal)
+            zoomAt(center, 0.8f, window);
+        else if (event.key.code == sf::Keyboard::Subtract || event.key.code == sf::Keyboard::Hyphen)
+            zoomAt(center, 1.25f, window);
+        else if (event.key.code == sf::Keyboard::Home)
+            reset();
+        else
+            return false;
+        return true;
+    }
+    default:
+        break;
+    }
+    return false;
+}
+
+const sf::View &Camera::getView() const
+{
+    return view;
+}
+
+sf::FloatRect Camera::visibleArea(const sf::View &view)
+{
+    sf::Vector2f center = view.getCenter();
+    sf::Vector2f size = view.getSize();
+    return sf::FloatRect(center.x - size.x / 2.f, center.y - size.y / 2.f, size.x, size.y);
+}
+
+#endif // CAMERA_H
@@ -0,0 +1,300 @@
+#ifndef CONCURRENT_STACK_H
+#define CONCURRENT_STACK_H
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+
+// Lock-free Treiber stack of ints with elimination backoff and hazard pointers;
+// snapshot() copies the stack as of one instant without stopping the workers.
+class ConcurrentStack
+{
+private:
+    struct Node
+    {
+        int value;
+        Node *next;
+
+        Node(int val) : value(val), next(nullptr) {}
+    };
+
+    static const std::size_t cacheLine = 64;
+    static const int hazardSlots = 64;      // Threads that can be inside push/pop at once
+    static const int retireThreshold = 128; // Retired nodes a slot collects before it scans
+    static const int eliminationSlots = 16;
+    static const int eliminationSpins = 64; // How long a push waits in the exchange array
+
+    // One per thread inside an operation; the retired list stays with the slot when
+    // the thread leaves, so the next owner frees it
+    struct alignas(cacheLine) HazardSlot
+    {
+        std::atomic<bool> inUse;
+        std::atomic<Node *> hazard;
+        std::vector<Node *> retired;
+
+        HazardSlot() : inUse(false), hazard(nullptr) {}
+    };
+
+    // Exchange cell: the state in the high 32 bits, a pushed value in the low 32 bits
+    enum : std::uint64_t
+    {
+        Empty = 0,
+        Offered = 1, // A push is waiting with its value
+        Taken = 2    // A pop took the value; the pushing thread resets the cell
+    };
+    struct alignas(cacheLine) EliminationCell
+    {
+        std::atomic<std::uint64_t> state;
+
+        EliminationCell() : state(0) {}
+    };
+
+    alignas(cacheLine) std::atomic<Node *> top;
+    alignas(cacheLine) std::atomic<int> snapshotReaders; // Reclamation waits while this is non-zero
+    HazardSlot slots[hazardSlots];
+    EliminationCell elimination[eliminationSlots];
+
+    static std::uint64_t pack(std::uint64_t state, int value);
+    static std::size_t threadHash();
+    EliminationCell &randomCell();
+
+    HazardSlot &acquireSlot();
+    void releaseSlot(HazardSlot &slot);
+    void retire(HazardSlot &slot, Node *node);
+    void scan(HazardSlot &slot);
+
+    bool eliminatePush(int value);
+    bool eliminatePop(int &value);
+
+public:
+    ConcurrentStack();
+    ~ConcurrentStack(); // No other thread may still be using the stack
+
+    ConcurrentStack(const ConcurrentStack &) = delete;
+    ConcurrentStack &operator=(const ConcurrentStack &) = delete;
+
+    void push(int value);
+    bool pop(int &value); // False if the stack was empty
+
+    // Copy of the stack as it was at one instant, top first
+    void snapshot(std::vector<int> &values);
+    bool empty() const;
+};
+
+// ------------------------------------------------------
+// Implementation of ConcurrentStack methods
+
+ConcurrentStack::ConcurrentStack() : top(nullptr), snapshotReaders(0)
+{
+}
+
+ConcurrentStack::~ConcurrentStack()
+{
+    Node *node = top.load(std::memory_order_relaxed);
+    while (node)
+    {
+        Node *next = node->next;
+        delete node;
+        node = next;
+    }
+    for (HazardSlot &slot : slots)
+    {
+        for (Node *retired : slot.retired)
+        {
+            delete retired;
+        }
+    }
+}
+
+std::uint64_t ConcurrentStack::pack(std::uint64_t state, int value)
+{
+    return state << 32 | static_cast<std::uint32_t>(value);
+}
+
+std::size_t ConcurrentStack::threadHash()
+{
+    static thread_local std::size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return hash;
+}
+
+// Cells are picked at random, so colliding threads soon spread out
+ConcurrentStack::EliminationCell &ConcurrentStack::randomCell()
+{
+    static thread_local std::uint32_t state = static_cast<std::uint32_t>(threadHash()) | 1;
+    state ^= state << 13; // xorshift32
+    state ^= state >> 17;
+    state ^= state << 5;
+    return elimination[state % eliminationSlots];
+}
+
+// Threads start looking at their own hashed slot, so a thread keeps getting the same one
+ConcurrentStack::HazardSlot &ConcurrentStack::acquireSlot()
+{
+    std::size_t start = threadHash();
+    while (true)
+    {
+        for (int i = 0; i < hazardSlots; ++i)
+        {
+            HazardSlot &slot = slots[(start + i) % hazardSlots];
+            bool expected = false;
+            if (!slot.inUse.load(std::memory_order_relaxed) &&
+                slot.inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                return slot;
+        }
+        std::this_thread::yield(); // More threads than slots; wait for one to leave
+    }
+}
+
+void ConcurrentStack::releaseSlot(HazardSlot &slot)
+{
+    slot.hazard.store(nullptr, std::memory_order_release);
+    slot.inUse.store(false, std::memory_order_release);
+}
+
+void ConcurrentStack::retire(HazardSlot &slot, Node *node)
+{
+    slot.retired.push_back(node);
+    if (slot.retired.size() >= retireThreshold)
+        scan(slot);
+}
+
+// Free the slot's retired nodes that no thread has published as a hazard
+void ConcurrentStack::scan(HazardSlot &slot)
+{
+    // A snapshot may be walking through retired nodes; try again on a later scan
+    if (snapshotReaders.load(std::memory_order_seq_cst) > 0)
+        return;
+
+    std::vector<Node *> hazards;
+    for (HazardSlot &other : slots)
+    {
+        Node *node = other.hazard.load(std::memory_order_seq_cst);
+        if (node)
+            hazards.push_back(node);
+    }
+    std::sort(hazards.begin(), hazards.end());
+
+    std::vector<Node *> kept;
+    for (Node *node : slot.retired)
+    {
+        if (std::binary_search(hazards.begin(), hazards.end(), node))
+            kept.push_back(node);
+        else
+            delete node;
+    }
+    slot.retired.swap(kept);
+}
+
+// Offer the value in a random cell and wait briefly for a pop to take it
+bool ConcurrentStack::eliminatePush(int value)
+{
+    EliminationCell &cell = randomCell();
+    std::uint64_t expected = pack(Empty, 0);
+    std::uint64_t offer = pack(Offered, value);
+    if (!cell.state.compare_exchange_strong(expected, offer, std::memory_order_acq_rel))
+        return false; // Someone else is using the cell
+
+    for (int spin = 0; spin < eliminationSpins; ++spin)
+    {
+        if (cell.state.load(std::memory_order_acquire) >> 32 == Taken)
+        {
+            cell.state.store(pack(Empty, 0), std::memory_order_release);
+            return true;
+        }
+    }
+
+    // Withdraw the offer, unless a pop took it in the meantime
+    expected = offer;
+    if (cell.state.compare_exchange_strong(expected, pack(Empty, 0), std::memory_order_acq_rel))
+        return false;
+    cell.state.store(pack(Empty, 0), std::memory_order_release);
+    return true;
+}
+
+// Take a value a push is offering in a random cell, if there is one
+bool ConcurrentStack::eliminatePop(int &value)
+{
+    EliminationCell &cell = randomCell();
+    std::uint64_t seen = cell.state.load(std::memory_order_acquire);
+    if (seen >> 32 != Offered)
+        return false;
+    if (!cell.state.compare_exchange_strong(seen, pack(Taken, 0), std::memory_order_acq_rel))
+        return false;
+    value = static_cast<int>(static_cast<std::uint32_t>(seen));
+    return true;
+}
+
+void ConcurrentStack::push(int value)
+{
+    Node *node = new Node(value);
+    node->next = top.load(std::memory_order_relaxed);
+    while (!top.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+    {
+        // Lost a race on top: meeting a pop in the exchange array finishes the push as well
+        if (eliminatePush(value))
+        {
+            delete node;
+            return;
+        }
+        node->next = top.load(std::memory_order_relaxed);
+    }
+}
+
+bool ConcurrentStack::pop(int &value)
+{
+    HazardSlot &slot = acquireSlot();
+    while (true)
+    {
+        Node *node = top.load(std::memory_order_acquire);
+        if (!node)
+        {
+            releaseSlot(slot);
+            return false;
+        }
+
+        // Publish the node, then check it is still on the stack: from then on it cannot be freed
+        slot.hazard.store(node, std::memory_order_seq_cst);
+        if (top.load(std::memory_order_seq_cst) != node)
+            continue;
+
+        // Sequentially consistent, so the scans that follow see every hazard and snapshot reader
+        if (top.compare_exchange_strong(node, node->next, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            value = node->value;
+            slot.hazard.store(nullptr, std::memory_order_release);
+            retire(slot, node);
+            releaseSlot(slot);
+            return true;
+        }
+
+        slot.hazard.store(nullptr, std::memory_order_release);
+        if (eliminatePop(value))
+        {
+            releaseSlot(slot);
+            return true;
+        }
+    }
+}
+
+void ConcurrentStack::snapshot(std::vector<int> &values)
+{
+    values.clear();
+
+    // Registering before reading top means every node reachable from it stays allocated
+    snapshotReaders.fetch_add(1, std::memory_order_seq_cst);
+    for (Node *node = top.load(std::memory_order_seq_cst); node; node = node->next)
+    {
+        values.push_back(node->value);
+    }
+    snapshotReaders.fetch_sub(1, std::memory_order_release);
+}
+
+bool ConcurrentStack::empty() const
+{
+    return top.load(std::memory_order_acquire) == nullptr;
+}
+
+#endif // CONCURRENT_STACK_H
@@ -0,0 +1,44 @@
+#ifndef FONT_CACHE_H
+#define FONT_CACHE_H
+
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <cstdlib>
+
+// One process-wide copy of Arial.ttf that every structure and the menu borrow.
+// The font is parsed on first use only, so render paths never touch the disk.
+class FontCache
+{
+public:
+    // Returns the shared font, loading it on the first call
+    static const sf::Font &get()
+    {
+        static sf::Font font;
+        static bool loaded = false;
+
+        if (!loaded)
+        {
+            if (!font.loadFromFile("Arial.ttf"))
+            {
+                std::cerr << "Error loading font!" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            loaded = true;
+        }
+        return font;
+    }
+
+    // Rasterize the glyphs used by node labels ahead of time, so the first
+    // frame at a new character size does not stall on glyph rendering
+    static void warmGlyphs(unsigned int characterSize)
+    {
+        const sf::Font &font = get();
+        const char *digits = "0123456789-";
+        for (const char *c = digits; *c; ++c)
+        {
+            font.getGlyph(static_cast<unsigned char>(*c), characterSize, false);
+        }
+    }
+};
+
+#endif // FONT_CACHE_H
@@ -0,0 +1,164 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <cstdio>
+
+// Decides when the main loop renders (VSync, FixedRate or Idle, which blocks in
+// waitEvent until something asks for a redraw) and shows frame time in the title.
+class FrameScheduler
+{
+public:
+    enum class Mode
+    {
+        VSync,
+        FixedRate,
+        Idle
+    };
+
+private:
+    sf::RenderWindow &window;
+    std::string title;
+    Mode mode;
+    unsigned int frameRate;
+
+    bool redrawRequested;
+    int runningAnimations;
+    bool waitForEvent; // Set in idle mode once the queue is drained, so the next event is awaited
+
+    sf::Clock frameClock;
+    sf::Clock titleClock;
+    sf::Time frameTime;
+    sf::Time averageFrameTime;
+    unsigned long renderedFrames;
+
+    void applyMode();
+
+public:
+    FrameScheduler(sf::RenderWindow &window, const std::string &title, Mode mode, unsigned int frameRate = 60);
+
+    void setMode(Mode newMode);
+    Mode getMode() const;
+
+    // Next pending event; in idle mode with nothing to draw, blocks until one arrives
+    bool nextEvent(sf::Event &event);
+
+    void requestRedraw();  // Something visible changed
+    void beginAnimation(); // Keep rendering every frame until the matching endAnimation
+    void endAnimation();
+
+    bool shouldRender() const;
+    void beginFrame();
+    void endFrame(); // Call before window.display(), so waiting on vsync is not counted
+
+    sf::Time getFrameTime() const;        // CPU time of the last rendered frame
+    sf::Time getAverageFrameTime() const; // Moving average over recent frames
+    unsigned long getRenderedFrames() const;
+};
+
+// ------------------------------------------------------
+// Implementation of FrameScheduler methods
+
+FrameScheduler::FrameScheduler(sf::RenderWindow &window, const std::string &title, Mode mode, unsigned int frameRate)
+    : window(window), title(title), mode(mode), frameRate(frameRate), redrawRequested(true),
+      runningAnimations(0), waitForEvent(false), renderedFrames(0)
+{
+    applyMode();
+}
+
+void FrameScheduler::applyMode()
+{
+    window.setVerticalSyncEnabled(mode == Mode::VSync);
+    window.setFramerateLimit(mode == Mode::VSync ? 0 : frameRate);
+}
+
+void FrameScheduler::setMode(Mode newMode)
+{
+    mode = newMode;
+    applyMode();
+    requestRedraw();
+}
+
+FrameScheduler::Mode FrameScheduler::getMode() const
+{
+    return mode;
+}
+
+bool FrameScheduler::nextEvent(sf::Event &event)
+{
+    if (waitForEvent && !shouldRender())
+    {
+        // Only the first event blocks, the rest of the queue is drained by polling
+        waitForEvent = false;
+        return window.waitEvent(event);
+    }
+    if (window.pollEvent(event))
+        return true;
+
+    // Drained: block again on the next call, whether or not this batch led to a frame
+    waitForEvent = mode == Mode::Idle;
+    return false;
+}
+
+void FrameScheduler::requestRedraw()
+{
+    redrawRequested = true;
+}
+
+void FrameScheduler::beginAnimation()
+{
+    ++runningAnimations;
+}
+
+void FrameScheduler::endAnimation()
+{
+    if (runningAnimations > 0)
+        --runningAnimations;
+    requestRedraw(); // Show the final state
+}
+
+bool FrameScheduler::shouldRender() const
+{
+    return mode != Mode::Idle || redrawRequested || runningAnimations > 0;
+}
+
+void FrameScheduler::beginFrame()
+{
+    frameClock.restart();
+}
+
+void FrameScheduler::endFrame()
+{
+    frameTime = frameClock.getElapsedTime();
+    averageFrameTime = renderedFrames == 0 ? frameTime
+                                           : sf::microseconds((averageFrameTime.asMicroseconds() * 15 + frameTime.asMicroseconds()) / 16);
+    ++renderedFrames;
+
+    redrawRequested = false;
+
+    if (titleClock.getElapsedTime() >= sf::seconds(1.f))
+    {
+        char stats[64];
+        std::snprintf(stats, sizeof(stats), " - %.3f ms/frame", averageFrameTime.asMicroseconds() / 1000.0);
+        window.setTitle(title + stats);
+        titleClock.restart();
+    }
+}
+
+sf::Time FrameScheduler::getFrameTime() const
+{
+    return frameTime;
+}
+
+sf::Time FrameScheduler::getAverageFrameTime() const
+{
+    return averageFrameTime;
+}
+
+unsigned long FrameScheduler::getRenderedFrames() const
+{
+    return renderedFrames;
+}
+
+#endif // FRAME_SCHEDULER_H
@@ -0,0 +1,419 @@
+#ifndef HEAP_CORE_H
+#define HEAP_CORE_H
+
+#include <vector>
+#include <cstddef>
+#include <new>
+#include <thread>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <cmath>
+
+// d-ary max-heap with each group of siblings on one cache line, so a sift-down
+// step reads all the children of a node from a single line.
+template <int Arity = 2>
+class HeapCore
+{
+    static_assert(Arity == 2 || Arity == 4 || Arity == 8, "HeapCore supports arities 2, 4 and 8");
+
+private:
+    static const std::size_t cacheLine = 64;
+    static const std::size_t padding = Arity - 1; // Unused slots before the root
+    static const std::size_t parallelThreshold = 1 << 18; // Smaller builds stay on one thread
+    static constexpr std::size_t sampleSize = 1 << 14;     // Keys read to estimate the cutoff of a large batch
+    static constexpr std::size_t minSampleHits = 32;       // Batches expected to hit fewer sampled keys grow a frontier instead
+
+    // Hands out cache-line aligned blocks, so the padding lines sibling groups up with lines
+    template <typename T>
+    struct AlignedAllocator
+    {
+        typedef T value_type;
+
+        AlignedAllocator() {}
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U> &) {}
+
+        T *allocate(std::size_t count)
+        {
+            return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(cacheLine)));
+        }
+        void deallocate(T *block, std::size_t)
+        {
+            ::operator delete(block, std::align_val_t(cacheLine));
+        }
+
+        template <typename U>
+        bool operator==(const AlignedAllocator<U> &) const { return true; }
+        template <typename U>
+        bool operator!=(const AlignedAllocator<U> &) const { return false; }
+    };
+
+    std::vector<int, AlignedAllocator<int>> keys; // padding unused slots, then the heap
+
+    void siftUp(std::size_t index);   // Move a larger key up towards the root
+    void siftDown(std::size_t index); // Move a smaller key down towards the leaves
+    void heapifySubtree(std::size_t root); // Floyd pass over the subtree below root, deepest level first
+    void heapify();                        // Restore the heap property over the whole array
+    void findLargest(std::size_t k, std::vector<int> &out, std::vector<std::size_t> &taken) const; // Keys of the k largest, and their slots parents first
+    std::uint64_t entry(std::size_t index) const; // A slot's key and slot packed to compare as one integer
+
+public:
+    HeapCore();
+
+    void push(int value);
+    void pop();             // Remove the maximum; does nothing when empty
+    const int &top() const; // The maximum; the heap must not be empty
+
+    // Add every value of [first, last) and restore the heap property in one O(n) pass
+    template <typename InputIt>
+    void build(InputIt first, InputIt last)
+    {
+        keys.insert(keys.end(), first, last);
+        heapify();
+    }
+
+    // Append the min(k, size()) largest keys to out in descending order, leaving the heap as is
+    void top_k(std::size_t k, std::vector<int> &out) const;
+    // Same, but also remove them from the heap
+    void pop_k(std::size_t k, std::vector<int> &out);
+
+    int operator[](std::size_t index) const; // Key in a slot, in array order
+    std::size_t size() const;
+    bool empty() const;
+    void reserve(std::size_t count);
+
+    static std::size_t parent(std::size_t index); // Slot of a node's parent, for index > 0
+};
+
+// ------------------------------------------------------
+// Implementation of HeapCore methods
+
+template <int Arity>
+HeapCore<Arity>::HeapCore() : keys(padding)
+{
+}
+
+template <int Arity>
+void HeapCore<Arity>::push(int value)
+{
+    keys.push_back(value);
+    siftUp(size() - 1);
+}
+
+template <int Arity>
+void HeapCore<Arity>::pop()
+{
+    if (empty())
+        return;
+
+    keys[padding] = keys.back();
+    keys.pop_back();
+    if (!empty())
+        siftDown(0);
+}
+
+template <int Arity>
+const int &HeapCore<Arity>::top() const
+{
+    return keys[padding];
+}
+
+template <int Arity>
+void HeapCore<Arity>::siftUp(std::size_t index)
+{
+    int *slots = keys.data() + padding;
+    int value = slots[index];
+    while (index > 0)
+    {
+        std::size_t parentIndex = parent(index);
+        if (value <= slots[parentIndex])
+            break; // Heap property holds from here up
+
+        slots[index] = slots[parentIndex]; // Pull the parent down into the hole
+        index = parentIndex;
+    }
+    slots[index] = value;
+}
+
+template <int Arity>
+void HeapCore<Arity>::siftDown(std::size_t index)
+{
+    int *slots = keys.data() + padding;
+    std::size_t count = size();
+    int value = slots[index];
+    while (true)
+    {
+        std::size_t firstChild = Arity * index + 1;
+        if (firstChild >= count)
+            break;
+
+        // Largest of the (up to Arity) children, all on one cache line
+        std::size_t lastChild = firstChild + Arity < count ? firstChild + Arity : count;
+        std::size_t largest = firstChild;
+        for (std::size_t child = firstChild + 1; child < lastChild; ++child)
+        {
+            if (slots[child] > slots[largest])
+                largest = child;
+        }
+
+        if (slots[largest] <= value)
+            break;
+
+        slots[index] = slots[largest]; // Push the child up into the hole
+        index = largest;
+    }
+    slots[index] = value;
+}
+
+template <int Arity>
+void HeapCore<Arity>::heapifySubtree(std::size_t root)
+{
+    // The subtree's nodes on each level form one contiguous range of slots
+    std::vector<std::pair<std::size_t, std::size_t>> levels;
+    std::size_t count = size();
+    for (std::size_t first = root, last = root; first < count; first = Arity * first + 1, last = Arity * last + Arity)
+    {
+        levels.push_back(std::make_pair(first, std::min(last, count - 1)));
+    }
+
+    for (std::size_t level = levels.size(); level-- > 0;)
+    {
+        for (std::size_t index = levels[level].second + 1; index-- > levels[level].first;)
+        {
+            siftDown(index);
+        }
+    }
+}
+
+template <int Arity>
+void HeapCore<Arity>::heapify()
+{
+    std::size_t count = size();
+    if (count < 2)
+        return;
+
+    unsigned int threads = std::thread::hardware_concurrency();
+    if (count < parallelThreshold || threads < 2)
+    {
+        for (std::size_t index = parent(count - 1) + 1; index-- > 0;)
+        {
+            siftDown(index);
+        }
+        return;
+    }
+
+    // Find the first level with a few subtrees per thread; those subtrees share no
+    // slots, so each thread heapifies its own share of them
+    std::size_t first = 0;
+    std::size_t last = 0;
+    while (last - first + 1 < 4 * threads && Arity * last + Arity < count)
+    {
+        first = Arity * first + 1;
+        last = Arity * last + Arity;
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([this, first, last, t, threads]() {
+            for (std::size_t root = first + t; root <= last; root += threads)
+            {
+                heapifySubtree(root);
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    // The levels above are a small tree whose subtrees are all heaps by now
+    for (std::size_t index = first; index-- > 0;)
+    {
+        siftDown(index);
+    }
+}
+
+template <int Arity>
+void HeapCore<Arity>::findLargest(std::size_t k, std::vector<int> &out, std::vector<std::size_t> &taken) const
+{
+    // The k largest keys form a subtree at the root
+    const int *slots = keys.data() + padding;
+    std::size_t count = size();
+    taken.reserve(k);
+    if (k * sampleSize < minSampleHits * count)
+    {
+        // Small batch: take the largest key on the frontier, then add its children to it
+        std::vector<std::uint64_t> frontier(1, entry(0));
+        while (taken.size() < k)
+        {
+            std::pop_heap(frontier.begin(), frontier.end());
+            std::size_t index = 0xFFFFFFFFu - static_cast<std::uint32_t>(frontier.back());
+            frontier.pop_back();
+            out.push_back(slots[index]);
+            taken.push_back(index);
+            for (std::size_t child = Arity * index + 1; child <= Arity * index + Arity && child < count; ++child)
+            {
+                frontier.push_back(entry(child));
+                std::push_heap(frontier.begin(), frontier.end());
+            }
+        }
+        return;
+    }
+
+    // Large batch: estimate from evenly spaced keys a cutoff that a few more than k
+    // keys reach, and collect the subtree of keys at or above it, parents first.
+    // A cutoff that falls short is lowered until the subtree holds k keys.
+    std::vector<int> sample;
+    for (std::size_t index = 0; index < count; index += std::max<std::size_t>(1, count / sampleSize))
+    {
+        sample.push_back(slots[index]);
+    }
+    std::size_t expected = k * sample.size() / count;
+    std::vector<std::size_t> pending;
+    std::vector<std::size_t> reached;
+    for (std::size_t margin = 2 * static_cast<std::size_t>(std::sqrt(static_cast<double>(expected))) + 8;; margin *= 4)
+    {
+        int cutoff = std::numeric_limits<int>::min();
+        if (expected + margin < sample.size())
+        {
+            std::nth_element(sample.begin(), sample.begin() + expected + margin, sample.end(), std::greater<int>());
+            cutoff = sample[expected + margin];
+        }
+
+        reached.clear();
+        pending.assign(1, 0);
+        while (!pending.empty())
+        {
+            std::size_t index = pending.back();
+            pending.pop_back();
+            if (slots[index] < cutoff)
+                continue; // Nothing below reaches the cutoff either
+
+            reached.push_back(index);
+            for (std::size_t child = Arity * index + 1; child <= Arity * index + Arity && child < count; ++child)
+            {
+                pending.push_back(child);
+            }
+        }
+        if (reached.size() >= k)
+            break;
+    }
+
+    // Keep the k largest of the subtree, which is a subtree again
+    std::vector<std::uint64_t> entries(reached.size());
+    std::transform(reached.begin(), reached.end(), entries.begin(), [this](std::size_t index) { return entry(index); });
+    std::nth_element(entries.begin(), entries.begin() + (k - 1), entries.end(), std::greater<std::uint64_t>());
+    std::uint64_t smallest = entries[k - 1];
+    std::size_t first = out.size();
+    for (std::size_t index : reached)
+    {
+        if (entry(index) >= smallest)
+        {
+            out.push_back(slots[index]);
+            taken.push_back(index);
+        }
+    }
+    std::sort(out.begin() + first, out.end(), std::greater<int>());
+}
+
+template <int Arity>
+std::uint64_t HeapCore<Arity>::entry(std::size_t index) const
+{
+    // The key is flipped to sort as unsigned, and of two equal keys the one in the
+    // lower slot sorts first, so a parent always sorts before its children
+    std::uint32_t key = static_cast<std::uint32_t>(keys[padding + index]) ^ 0x80000000u;
+    return static_cast<std::uint64_t>(key) << 32 | (0xFFFFFFFFu - static_cast<std::uint32_t>(index));
+}
+
+template <int Arity>
+void HeapCore<Arity>::top_k(std::size_t k, std::vector<int> &out) const
+{
+    k = std::min(k, size());
+    if (k == 0)
+        return;
+
+    std::vector<std::size_t> taken;
+    findLargest(k, out, taken);
+}
+
+template <int Arity>
+void HeapCore<Arity>::pop_k(std::size_t k, std::vector<int> &out)
+{
+    std::size_t count = size();
+    k = std::min(k, count);
+    if (k == 0)
+        return;
+
+    std::vector<std::size_t> taken;
+    findLargest(k, out, taken);
+
+    // Fill the holes that stay inside the array with the keys past its new end that
+    // were not taken; every hole's parent is a hole too, so re-sifting the holes
+    // children first restores the heap
+    std::size_t remaining = count - k;
+    std::vector<std::size_t> takenPastEnd;
+    for (std::size_t index : taken)
+    {
+        if (index >= remaining)
+            takenPastEnd.push_back(index);
+    }
+    std::sort(takenPastEnd.begin(), takenPastEnd.end());
+
+    std::size_t filler = count;
+    for (std::size_t index : taken)
+    {
+        if (index >= remaining)
+            continue;
+
+        --filler;
+        while (!takenPastEnd.empty() && takenPastEnd.back() == filler)
+        {
+            takenPastEnd.pop_back();
+            --filler;
+        }
+        keys[padding + index] = keys[padding + filler];
+    }
+    keys.resize(padding + remaining);
+
+    for (std::size_t hole = taken.size(); hole-- > 0;)
+    {
+        if (taken[hole] < remaining)
+            siftDown(taken[hole]);
+    }
+}
+
+template <int Arity>
+int HeapCore<Arity>::operator[](std::size_t index) const
+{
+    return keys[padding + index];
+}
+
+template <int Arity>
+std::size_t HeapCore<Arity>::size() const
+{
+    return keys.size() - padding;
+}
+
+template <int Arity>
+bool HeapCore<Arity>::empty() const
+{
+    return keys.size() == padding;
+}
+
+template <int Arity>
+void HeapCore<Arity>::reserve(std::size_t count)
+{
+    keys.reserve(padding + count);
+}
+
+template <int Arity>
+std::size_t HeapCore<Arity>::parent(std::size_t index)
+{
+    return (index - 1) / Arity;
+}
+
+#endif // HEAP_CORE_H
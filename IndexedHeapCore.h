@@ -0,0 +1,256 @@
+#ifndef INDEXED_HEAP_CORE_H
+#define INDEXED_HEAP_CORE_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// d-ary max-heap whose elements are changed or erased in place through the handle
+// enqueue returns. A handle stays invalid once its element leaves the queue.
+template <int Arity = 4>
+class IndexedHeapCore
+{
+    static_assert(Arity >= 2, "IndexedHeapCore needs at least two children per node");
+
+public:
+    // An id in the low 32 bits and its generation in the high ones. Ids are reused,
+    // but each reuse bumps the generation, so a handle kept after its element left
+    // the queue never refers to a later element (until one id is reused 2^32 times)
+    typedef std::uint64_t Handle;
+
+private:
+    struct Entry
+    {
+        int priority;
+        std::uint32_t id;
+    };
+
+    static const std::size_t None = static_cast<std::size_t>(-1);
+
+    std::vector<Entry> entries;              // The heap, in array order
+    std::vector<std::size_t> positions;      // Slot of each id, None when not queued
+    std::vector<std::uint32_t> generations;  // Current generation of each id
+    std::vector<std::uint32_t> freeIds;      // Ids of elements that left the queue
+
+    Handle handleOf(std::uint32_t id) const;
+    std::uint32_t idOf(Handle handle) const;
+
+    void place(std::size_t slot, const Entry &entry); // Write an entry and record its slot
+    void siftUp(std::size_t slot);
+    void siftDown(std::size_t slot);
+    void removeAt(std::size_t slot);
+
+public:
+    Handle enqueue(int priority);
+    void update(Handle handle, int priority); // Raise or lower the priority of a queued element; does nothing otherwise
+    void erase(Handle handle);                // Remove a queued element wherever it is; does nothing otherwise
+    void pop();                               // Remove the highest priority element; does nothing when empty
+
+    Handle top() const;       // Handle of the highest priority element; the queue must not be empty
+    int topPriority() const;  // The queue must not be empty
+    int priority(Handle handle) const; // INT_MIN when the element is not queued
+    bool contains(Handle handle) const;
+
+    std::size_t size() const;
+    bool empty() const;
+    void clear();
+};
+
+// ------------------------------------------------------
+// Implementation of IndexedHeapCore methods
+
+template <int Arity>
+const std::size_t IndexedHeapCore<Arity>::None;
+
+template <int Arity>
+void IndexedHeapCore<Arity>::place(std::size_t slot, const Entry &entry)
+{
+    entries[slot] = entry;
+    positions[entry.id] = slot;
+}
+
+template <int Arity>
+typename IndexedHeapCore<Arity>::Handle IndexedHeapCore<Arity>::handleOf(std::uint32_t id) const
+{
+    return static_cast<Handle>(generations[id]) << 32 | id;
+}
+
+template <int Arity>
+std::uint32_t IndexedHeapCore<Arity>::idOf(Handle handle) const
+{
+    return static_cast<std::uint32_t>(handle);
+}
+
+template <int Arity>
+void IndexedHeapCore<Arity>::siftUp(std::size_t slot)
+{
+    Entry entry = entries[slot];
+    while (slot > 0)
+    {
+        std::size_t parent = (slot - 1) / Arity;
+        if (entry.priority <= entries[parent].priority)
+            break;
+
+        place(slot, entries[parent]); // Pull the parent down into the hole
+        slot = parent;
+    }
+    place(slot, entry);
+}
+
+template <int Arity>
+void IndexedHeapCore<Arity>::siftDown(std::size_t slot)
+{
+    Entry entry = entries[slot];
+    std::size_t count = entries.size();
+    while (true)
+    {
+        std::size_t firstChild = Arity * slot + 1;
+        if (firstChild >= count)
+            break;
+
+        std::size_t lastChild = firstChild + Arity < count ? firstChild + Arity : count;
+        std::size_t largest = firstChild;
+        for (std::size_t child = firstChild + 1; child < lastChild; ++child)
+        {
+            if (entries[child].priority > entries[largest].priority)
+                largest = child;
+        }
+
+        if (entries[largest].priority <= entry.priority)
+            break;
+
+        place(slot, entries[largest]); // Push the child up into the hole
+        slot = largest;
+    }
+    place(slot, entry);
+}
+
+// Move the last entry into the slot and re-sift it whichever way it has to go
+template <int Arity>
+void IndexedHeapCore<Arity>::removeAt(std::size_t slot)
+{
+    std::uint32_t id = entries[slot].id;
+    positions[id] = None;
+    ++generations[id]; // Handles to the removed element go stale
+    freeIds.push_back(id);
+
+    Entry last = entries.back();
+    entries.pop_back();
+    if (slot == entries.size())
+        return; // The removed entry was the last one
+
+    int removedPriority = entries[slot].priority;
+    place(slot, last);
+    if (last.priority > removedPriority)
+        siftUp(slot);
+    else
+        siftDown(slot);
+}
+
+template <int Arity>
+typename IndexedHeapCore<Arity>::Handle IndexedHeapCore<Arity>::enqueue(int priority)
+{
+    std::uint32_t id;
+    if (freeIds.empty())
+    {
+        id = static_cast<std::uint32_t>(positions.size());
+        positions.push_back(None);
+        generations.push_back(0);
+    }
+    else
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+
+    Entry entry = {priority, id};
+    entries.push_back(entry);
+    positions[id] = entries.size() - 1;
+    siftUp(entries.size() - 1);
+    return handleOf(id);
+}
+
+template <int Arity>
+void IndexedHeapCore<Arity>::update(Handle handle, int priority)
+{
+    if (!contains(handle))
+        return;
+
+    std::size_t slot = positions[idOf(handle)];
+    int oldPriority = entries[slot].priority;
+    entries[slot].priority = priority;
+    if (priority > oldPriority)
+        siftUp(slot);
+    else if (priority < oldPriority)
+        siftDown(slot);
+}
+
+template <int Arity>
+void IndexedHeapCore<Arity>::erase(Handle handle)
+{
+    if (contains(handle))
+        removeAt(positions[idOf(handle)]);
+}
+
+template <int Arity>
+void IndexedHeapCore<Arity>::pop()
+{
+    if (!entries.empty())
+        removeAt(0);
+}
+
+template <int Arity>
+typename IndexedHeapCore<Arity>::Handle IndexedHeapCore<Arity>::top() const
+{
+    return handleOf(entries[0].id);
+}
+
+template <int Arity>
+int IndexedHeapCore<Arity>::topPriority() const
+{
+    return entries[0].priority;
+}
+
+template <int Arity>
+int IndexedHeapCore<Arity>::priority(Handle handle) const
+{
+    if (!contains(handle))
+        return std::numeric_limits<int>::min();
+
+    return entries[positions[idOf(handle)]].priority;
+}
+
+template <int Arity>
+bool IndexedHeapCore<Arity>::contains(Handle handle) const
+{
+    std::uint32_t id = idOf(handle);
+    return id < positions.size() && positions[id] != None && handleOf(id) == handle;
+}
+
+template <int Arity>
+std::size_t IndexedHeapCore<Arity>::size() const
+{
+    return entries.size();
+}
+
+template <int Arity>
+bool IndexedHeapCore<Arity>::empty() const
+{
+    return entries.empty();
+}
+
+template <int Arity>
+void IndexedHeapCore<Arity>::clear()
+{
+    // Ids and generations are kept, so handles from before stay stale
+    for (const Entry &entry : entries)
+    {
+        positions[entry.id] = None;
+        ++generations[entry.id];
+        freeIds.push_back(entry.id);
+    }
+    entries.clear();
+}
+
+#endif // INDEXED_HEAP_CORE_H
@@ -0,0 +1,20 @@
+#ifndef ITERATOR_RANGE_H
+#define ITERATOR_RANGE_H
+
+// A pair of iterators that range-for can walk, returned by the trees' range(lo, hi)
+template <typename Iterator>
+class IteratorRange
+{
+private:
+    Iterator first;
+    Iterator last;
+
+public:
+    IteratorRange(Iterator first, Iterator last) : first(first), last(last) {}
+
+    Iterator begin() const { return first; }
+    Iterator end() const { return last; }
+    bool empty() const { return first == last; }
+};
+
+#endif // ITERATOR_RANGE_H
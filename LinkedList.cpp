@@ -1,89 +1,64 @@
 #include "LinkedList.h"
 
-LinkedList::Node::Node(int val) : value(val), next(nullptr), shape(30) // Shape size: 30px
+LinkedList::LinkedList() : view(30.f, sf::Color::Green) // Shape size: 30px, filled green
 {
-    shape.setFillColor(sf::Color::Green); // Set the circle's fill color to green
 }
 
-LinkedList::LinkedList() : head(nullptr)
+void LinkedList::placeNode(const Node *node)
 {
-    setupFont();
+    view.setPosition(node->id, sf::Vector2f(100, 100 + (node->id ? 100 * (rand() % 5) : 0))); // Random Y-offset to prevent overlap
 }
 
-LinkedList::~LinkedList()
+void LinkedList::insert(int value)
 {
-    Node *current = head;
-    while (current)
-    {
-        Node *next = current->next; // Save the next node
-        delete current;             // Delete the current node
-        current = next;             // Move to the next node
-    }
+    push_back(value);
 }
 
-void LinkedList::setupFont()
+void LinkedList::push_back(int value)
 {
-    if (!font.loadFromFile("Arial.ttf"))
-    { // Ensure the font file exists and is loaded
-        std::cerr << "Error loading font!" << std::endl;
-        exit(EXIT_FAILURE);
-    }
+    Node *newNode = list.push_back(value); // Link the new node after the tail
+    view.resize(list.size());
+    placeNode(newNode);
+    scene.invalidate(); // The cached drawing no longer matches the list
 }
 
-void LinkedList::insert(int value)
+void LinkedList::visualize(sf::RenderTarget &target)
 {
-    Node *newNode = new Node(value);
-    newNode->shape.setPosition(100, 100 + (head ? 100 * (rand() % 5) : 0)); // Random Y-offset to prevent overlap
+    if (!list.getHead()) // If the list is empty, do nothing
+        return;
 
-    if (!head)
+    if (scene.needsRebuild(target)) // Only rebuild the geometry after the list changed
     {
-        head = newNode; // First node inserted, set head to point to it
-    }
-    else
-    {
-        Node *temp = head;
-        while (temp->next) // Traverse to the end of the list
-        {
-            temp = temp->next;
-        }
-        temp->next = newNode; // Link the new node at the end
-    }
-}
-
-void LinkedList::visualize(sf::RenderWindow &window)
-{
-    if (!head) // If the list is empty, do nothing
-        return;
+        BatchRenderer &batch = scene.rebuild(target);
+        Node *current = list.getHead(); // Start from the head (first node)
+        float radius = view.getRadius();
 
-    Node *current = head;                     // Start from the head (first node)
-    sf::Text valueText("", font, 20);         // Text for displaying node value
-    valueText.setFillColor(sf::Color::White); // Set text color to white
+        while (current)
+        {
+            sf::Vector2f position = view.getPosition(current->id);
+            batch.addCircle(position + sf::Vector2f(radius, radius), radius, view.getColor(current->id)); // Draw the node (circle)
 
-    while (current)
-    {
-        window.draw(current->shape); // Draw the node (circle)
+            // Display the node's value inside the circle
+            batch.addText(std::to_string(current->value), FontCache::get(), 20, position + sf::Vector2f(5, 5), sf::Color::White);
 
-        // Display the node's value inside the circle
-        valueText.setString(std::to_string(current->value)); // Convert value to string
-        valueText.setPosition(current->shape.getPosition().x + 5, current->shape.getPosition().y + 5);
-        window.draw(valueText);
+            // Draw a line connecting the nodes if there is a next node
+            if (current->next)
+            {
+                batch.addLine(position, view.getPosition(current->next->id), sf::Color::White);
+            }
 
-        // Draw a line connecting the nodes if there is a next node
-        if (current->next)
-        {
-            sf::VertexArray line(sf::Lines, 2);
-            line[0].position = current->shape.getPosition();       // Current node position
-            line[1].position = current->next->shape.getPosition(); // Next node position
-            line[0].color = sf::Color::White;                      // Set line color to white
-            line[1].color = sf::Color::White;
-            window.draw(line); // Draw the line between nodes
+            current = current->next; // Move to the next node in the list
         }
-
-        current = current->next; // Move to the next node in the list
     }
+    scene.draw(target); // Re-submit the cached geometry
 }
 
 LinkedList::Node *LinkedList::getHead() const
 {
-    return head;
+    return list.getHead();
+}
+
+std::size_t LinkedList::size() const
+{
+    return list.size();
 }
@@ -1,122 +1,111 @@
 #include <SFML/Graphics.hpp>
 #include <iostream>
+#include "FontCache.h"
+#include "RetainedScene.h"
+#include "LinkedListCore.h"
+#include "NodeView.h"
 
 class LinkedList
 {
 public:
-    struct Node
-    {
-        int value;
-        Node *next;
-        sf::CircleShape shape; // Visual representation of the node
-
-        Node(int val) : value(val), next(nullptr), shape(20)
-        {
-            shape.setFillColor(sf::Color::Blue);
-        }
-    };
+    typedef LinkedListCore::Node Node;
 
 private:
-    Node *head;
-    sf::Font font;
+    LinkedListCore list; // Values and links only
+    NodeView view;       // Position and color of every node, indexed by id
+    RetainedScene scene; // Cached geometry, rebuilt only after insert
+
+    void placeNode(const Node *node); // Set the on-screen position of a new node
 
 public:
     LinkedList();
-    ~LinkedList();
 
     void insert(int value);                   // Insert a new node with a value
-    void visualize(sf::RenderWindow &window); // Visualize the list
+    void push_back(int value);                // Append a value in O(1)
+    void visualize(sf::RenderTarget &target); // Visualize the list
+
+    // Append a batch of values, linking them to the list and invalidating the drawing once
+    template <typename InputIt>
+    void append_range(InputIt first, InputIt last)
+    {
+        Node *newNode = list.append_range(first, last);
+        if (!newNode)
+            return;
+
+        view.resize(list.size());
+        for (; newNode; newNode = newNode->next)
+        {
+            placeNode(newNode);
+        }
+        scene.invalidate();
+    }
 
-    void setupFont();
     Node *getHead() const;
+    std::size_t size() const;
 };
 
-LinkedList::LinkedList() : head(nullptr)
+LinkedList::LinkedList() : view(20.f, sf::Color::Blue)
 {
-    setupFont();
 }
 
-LinkedList::~LinkedList()
+// Nodes sit in a row with a 100px gap, the first one at (100, 300)
+void LinkedList::placeNode(const Node *node)
 {
-    Node *current = head;
-    while (current)
-    {
-        Node *next = current->next;
-        delete current;
-        current = next;
-    }
+    view.setPosition(node->id, sf::Vector2f(100.f + 100.f * node->id, 300.f));
 }
 
-void LinkedList::setupFont()
+void LinkedList::insert(int value)
 {
-    if (!font.loadFromFile("Arial.ttf"))
-    { // Make sure the path to your font is correct
-        std::cerr << "Error loading font!" << std::endl;
-        exit(EXIT_FAILURE);
-    }
+    push_back(value);
 }
 
-void LinkedList::insert(int value)
+void LinkedList::push_back(int value)
 {
-    Node *newNode = new Node(value);
-
-    // Position the node horizontally, with a 100px gap between nodes
-    if (!head)
-    {
-        newNode->shape.setPosition(100, 300); // First node at (100, 300) - fixed Y for horizontal alignment
-        head = newNode;
-    }
-    else
-    {
-        Node *temp = head;
-        int xOffset = 100; // Horizontal offset between nodes
-        // Traverse to the last node
-        while (temp->next)
-        {
-            temp = temp->next;
-            xOffset += 100; // Increase offset for each node
-        }
-        newNode->shape.setPosition(xOffset, 300); // Set new node's position horizontally
-        temp->next = newNode;                     // Attach the new node to the list
-    }
+    Node *newNode = list.push_back(value);
+    view.resize(list.size());
+    placeNode(newNode);
+    scene.invalidate();
 }
 
-void LinkedList::visualize(sf::RenderWindow &window)
+void LinkedList::visualize(sf::RenderTarget &target)
 {
-    if (!head)
+    if (!list.getHead())
         return;
 
-    Node *current = head;
-    sf::Text valueText("", font, 20);
-    valueText.setFillColor(sf::Color::White);
-
-    while (current)
+    if (scene.needsRebuild(target))
     {
-        window.draw(current->shape); // Draw the node
+        BatchRenderer &batch = scene.rebuild(target);
+        Node *current = list.getHead();
+        float radius = view.getRadius();
 
-        // Display the value inside the circle
-        valueText.setString(std::to_string(current->value));
-        valueText.setPosition(current->shape.getPosition().x + 5, current->shape.getPosition().y + 5);
-        window.draw(valueText);
-
-        // Draw the link to the next node (if it exists)
-        if (current->next)
+        while (current)
         {
-            sf::VertexArray line(sf::Lines, 2);
-            line[0].position = current->shape.getPosition() + sf::Vector2f(20, 0);        // Start at the edge of the current node
-            line[1].position = current->next->shape.getPosition() + sf::Vector2f(-20, 0); // End at the edge of the next node
-            line[0].color = sf::Color::White;
-            line[1].color = sf::Color::White;
-
-            // Optionally, you can add more visual styling like line thickness or transparency
-            window.draw(line);
-        }
+            sf::Vector2f position = view.getPosition(current->id);
+            batch.addCircle(position + sf::Vector2f(radius, radius), radius, view.getColor(current->id)); // Draw the node
+
+            // Display the value inside the circle
+            batch.addText(std::to_string(current->value), FontCache::get(), 20, position + sf::Vector2f(5, 5), sf::Color::White);
+
+            // Draw the link to the next node (if it exists)
+            if (current->next)
+            {
+                batch.addLine(position + sf::Vector2f(20, 0),                          // Start at the edge of the current node
+                              view.getPosition(current->next->id) + sf::Vector2f(-20, 0), // End at the edge of the next node
+                              sf::Color::White);
+            }
 
-        current = current->next;
+            current = current->next;
+        }
     }
+    scene.draw(target);
 }
 
 LinkedList::Node *LinkedList::getHead() const
 {
-    return head;
+    return list.getHead();
+}
+
+std::size_t LinkedList::size() const
+{
+    return list.size();
 }
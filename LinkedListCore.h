@@ -0,0 +1,113 @@
+#ifndef LINKED_LIST_CORE_H
+#define LINKED_LIST_CORE_H
+
+#include <cstddef>
+
+// Singly linked list of ints with a tail pointer, so append and size() are O(1).
+class LinkedListCore
+{
+public:
+    struct Node
+    {
+        int value;
+        int id; // Position in insertion order, the key of the node's view data
+        Node *next;
+
+        Node(int val, int nodeId) : value(val), id(nodeId), next(nullptr) {}
+    };
+
+private:
+    Node *head;
+    Node *tail;
+    std::size_t count;
+
+public:
+    LinkedListCore();
+    ~LinkedListCore();
+
+    LinkedListCore(const LinkedListCore &) = delete;
+    LinkedListCore &operator=(const LinkedListCore &) = delete;
+
+    Node *push_back(int value); // Append a value at the end and return its node
+
+    // Append every value of [first, last) in order. The new nodes are chained up
+    // on their own and linked to the tail once. Returns the first new node, or
+    // nullptr if the range was empty.
+    template <typename InputIt>
+    Node *append_range(InputIt first, InputIt last)
+    {
+        Node *batchHead = nullptr;
+        Node *batchTail = nullptr;
+        int id = static_cast<int>(count);
+        for (; first != last; ++first)
+        {
+            Node *newNode = new Node(*first, id++);
+            if (batchTail)
+                batchTail->next = newNode;
+            else
+                batchHead = newNode;
+            batchTail = newNode;
+        }
+
+        if (!batchHead)
+            return nullptr;
+        if (tail)
+            tail->next = batchHead;
+        else
+            head = batchHead;
+        tail = batchTail;
+        count = id;
+        return batchHead;
+    }
+
+    Node *getHead() const;
+    Node *getTail() const;
+    std::size_t size() const;
+};
+
+// ------------------------------------------------------
+// Implementation of LinkedListCore methods
+
+LinkedListCore::LinkedListCore() : head(nullptr), tail(nullptr), count(0)
+{
+}
+
+LinkedListCore::~LinkedListCore()
+{
+    Node *current = head;
+    while (current)
+    {
+        Node *next = current->next;
+        delete current;
+        current = next;
+    }
+}
+
+LinkedListCore::Node *LinkedListCore::push_back(int value)
+{
+    Node *newNode = new Node(value, static_cast<int>(count));
+    if (tail)
+        tail->next = newNode;
+    else
+        head = newNode;
+    tail = newNode;
+    ++count;
+    return newNode;
+}
+
+LinkedListCore::Node *LinkedListCore::getHead() const
+{
+    return head;
+}
+
+LinkedListCore::Node *LinkedListCore::getTail() const
+{
+    return tail;
+}
+
+std::size_t LinkedListCore::size() const
+{
+    return count;
+}
+
+#endif // LINKED_LIST_CORE_H
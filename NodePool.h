@@ -0,0 +1,192 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// Slab allocator with a free list: allocate, release, clear() and splice() of
+// another pool are O(1), and blocks are only freed when the pool is destroyed.
+template <typename T>
+class NodePool
+{
+private:
+    static const std::size_t blockSize = 256; // Nodes per block
+
+    union Slot
+    {
+        Slot *nextFree;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    struct Block
+    {
+        Block *next;
+        Slot slots[blockSize];
+    };
+
+    // Blocks before current are carved out completely, blocks after it not at all
+    Block *blocks;    // First block of the chain
+    Block *current;   // Block new slots are carved from
+    Block *lastBlock; // End of the chain, so splice does not walk it
+    std::size_t used; // Slots carved out of current
+    Slot *freeList;   // Released slots, most recent first
+    Slot *lastFree;   // End of the free list, for the same reason
+
+    void nextBlock();  // Move on to the next unused block, allocating one if there is none
+    void freeRest();   // Put the uncarved slots of current on the free list
+
+public:
+    NodePool();
+    ~NodePool(); // Frees the blocks without running the destructors of live nodes
+
+    NodePool(const NodePool &) = delete;
+    NodePool &operator=(const NodePool &) = delete;
+
+    // Construct a node in a free slot
+    template <typename... Args>
+    T *allocate(Args &&...args)
+    {
+        Slot *slot;
+        if (freeList)
+        {
+            slot = freeList;
+            freeList = slot->nextFree;
+            if (!freeList)
+                lastFree = nullptr;
+        }
+        else
+        {
+            if (!current || used == blockSize)
+                nextBlock();
+            slot = &current->slots[used++];
+        }
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    void release(T *node);        // Destroy a node and put its slot on the free list
+    void splice(NodePool &other); // Take over other's blocks and free slots; other ends up empty
+    void clear();                 // Forget every node at once, without running destructors
+};
+
+// ------------------------------------------------------
+// Implementation of NodePool methods
+
+template <typename T>
+NodePool<T>::NodePool()
+    : blocks(nullptr), current(nullptr), lastBlock(nullptr), used(0), freeList(nullptr), lastFree(nullptr)
+{
+}
+
+template <typename T>
+NodePool<T>::~NodePool()
+{
+    while (blocks)
+    {
+        Block *next = blocks->next;
+        delete blocks;
+        blocks = next;
+    }
+}
+
+template <typename T>
+void NodePool<T>::nextBlock()
+{
+    if (current && current->next)
+    {
+        current = current->next; // Left over from before a clear or a splice
+    }
+    else
+    {
+        Block *block = new Block;
+        block->next = nullptr;
+        if (lastBlock)
+            lastBlock->next = block;
+        else
+            blocks = block;
+        lastBlock = block;
+        current = block;
+    }
+    used = 0;
+}
+
+template <typename T>
+void NodePool<T>::freeRest()
+{
+    for (; current && used < blockSize; ++used)
+    {
+        Slot *slot = &current->slots[used];
+        slot->nextFree = freeList;
+        freeList = slot;
+        if (!lastFree)
+            lastFree = slot;
+    }
+}
+
+template <typename T>
+void NodePool<T>::release(T *node)
+{
+    node->~T();
+    Slot *slot = reinterpret_cast<Slot *>(node);
+    slot->nextFree = freeList;
+    freeList = slot;
+    if (!lastFree)
+        lastFree = slot;
+}
+
+template <typename T>
+void NodePool<T>::splice(NodePool &other)
+{
+    // Other's current block is part carved, part not; the uncarved part becomes free
+    // slots, which costs at most one block's worth of steps. Other can have free
+    // slots without blocks of its own, when they were released into it from elsewhere.
+    other.freeRest();
+    if (other.freeList)
+    {
+        other.lastFree->nextFree = freeList;
+        if (!freeList)
+            lastFree = other.lastFree;
+        freeList = other.freeList;
+    }
+
+    if (!blocks)
+    {
+        blocks = other.blocks;
+        current = other.current;
+        lastBlock = other.lastBlock;
+        used = other.blocks ? blockSize : 0;
+    }
+    else if (other.blocks)
+    {
+        // Other's carved blocks go in front, its unused blocks right after current
+        Block *otherUnused = other.current->next;
+        Block *unused = current->next;
+        other.current->next = blocks;
+        blocks = other.blocks;
+        if (otherUnused)
+        {
+            current->next = otherUnused;
+            other.lastBlock->next = unused;
+            if (!unused)
+                lastBlock = other.lastBlock;
+        }
+    }
+
+    other.blocks = nullptr;
+    other.current = nullptr;
+    other.lastBlock = nullptr;
+    other.used = 0;
+    other.freeList = nullptr;
+    other.lastFree = nullptr;
+}
+
+template <typename T>
+void NodePool<T>::clear()
+{
+    freeList = nullptr;
+    lastFree = nullptr;
+    current = blocks;
+    used = 0;
+}
+
+#endif // NODE_POOL_H
@@ -0,0 +1,80 @@
+#ifndef NODE_VIEW_H
+#define NODE_VIEW_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+// How a structure's nodes look on screen: colors and positions in arrays indexed
+// by node id, kept out of the nodes themselves.
+class NodeView
+{
+private:
+    std::vector<sf::Vector2f> positions; // Top-left corner of each node's circle
+    std::vector<sf::Color> colors;
+    float radius;
+    sf::Color defaultColor; // Color of newly added nodes
+
+public:
+    NodeView(float radius, sf::Color defaultColor);
+
+    void resize(std::size_t count); // Grow or shrink to count nodes, new ones get the default color
+    void clear();
+    std::size_t size() const;
+
+    void setPosition(int id, sf::Vector2f position);
+    sf::Vector2f getPosition(int id) const;
+    void setColor(int id, sf::Color color);
+    sf::Color getColor(int id) const;
+    float getRadius() const;
+};
+
+// ------------------------------------------------------
+// Implementation of NodeView methods
+
+NodeView::NodeView(float radius, sf::Color defaultColor) : radius(radius), defaultColor(defaultColor)
+{
+}
+
+void NodeView::resize(std::size_t count)
+{
+    positions.resize(count);
+    colors.resize(count, defaultColor);
+}
+
+void NodeView::clear()
+{
+    positions.clear();
+    colors.clear();
+}
+
+std::size_t NodeView::size() const
+{
+    return colors.size();
+}
+
+void NodeView::setPosition(int id, sf::Vector2f position)
+{
+    positions[id] = position;
+}
+
+sf::Vector2f NodeView::getPosition(int id) const
+{
+    return positions[id];
+}
+
+void NodeView::setColor(int id, sf::Color color)
+{
+    colors[id] = color;
+}
+
+sf::Color NodeView::getColor(int id) const
+{
+    return colors[id];
+}
+
+float NodeView::getRadius() const
+{
+    return radius;
+}
+
+#endif // NODE_VIEW_H
@@ -0,0 +1,203 @@
+#ifndef PAIRING_HEAP_CORE_H
+#define PAIRING_HEAP_CORE_H
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include "NodePool.h"
+
+// Max pairing heap of ints: push and meld are O(1), and meld() splices the other
+// heap's NodePool into this one instead of copying its nodes.
+class PairingHeapCore
+{
+public:
+    struct Node
+    {
+        int key;
+        Node *child;   // First child, whose key is not larger than this one
+        Node *sibling; // Next child of the same parent
+
+        Node(int value) : key(value), child(nullptr), sibling(nullptr) {}
+    };
+
+private:
+    NodePool<Node> pool;
+    Node *root;
+    std::size_t count;
+
+    static Node *link(Node *a, Node *b);   // Merge two roots without siblings into one
+    static Node *combine(Node *first);     // Merge a sibling list into one tree, two-pass
+
+public:
+    PairingHeapCore();
+
+    PairingHeapCore(const PairingHeapCore &) = delete;
+    PairingHeapCore &operator=(const PairingHeapCore &) = delete;
+
+    void push(int value);
+    void pop();             // Remove the maximum; does nothing when empty
+    const int &top() const; // The maximum; the heap must not be empty
+
+    // Move every element of other into this heap in O(1); other ends up empty
+    void meld(PairingHeapCore &other);
+
+    // Append the min(k, size()) largest keys to out in descending order, leaving the
+    // heap as is. Walks only the nodes above the k-th largest key and their children.
+    void top_k(std::size_t k, std::vector<int> &out) const;
+    // Same, but also remove them from the heap
+    void pop_k(std::size_t k, std::vector<int> &out);
+
+    const Node *getRoot() const; // For drawing the tree; nullptr when empty
+    std::size_t size() const;
+    bool empty() const;
+    void clear();
+};
+
+// ------------------------------------------------------
+// Implementation of PairingHeapCore methods
+
+PairingHeapCore::PairingHeapCore() : root(nullptr), count(0)
+{
+}
+
+PairingHeapCore::Node *PairingHeapCore::link(Node *a, Node *b)
+{
+    if (b->key > a->key)
+        std::swap(a, b);
+
+    b->sibling = a->child; // b becomes a's first child
+    a->child = b;
+    return a;
+}
+
+PairingHeapCore::Node *PairingHeapCore::combine(Node *first)
+{
+    if (!first)
+        return nullptr;
+
+    // First pass: link neighbours in pairs, stacking the results through sibling
+    Node *pairs = nullptr;
+    while (first)
+    {
+        Node *a = first;
+        Node *b = a->sibling;
+        if (!b)
+        {
+            a->sibling = pairs;
+            pairs = a;
+            break;
+        }
+
+        first = b->sibling;
+        a->sibling = nullptr;
+        b->sibling = nullptr;
+        Node *linked = link(a, b);
+        linked->sibling = pairs;
+        pairs = linked;
+    }
+
+    // Second pass: the stack has the last pair on top, so this links right to left
+    Node *result = pairs;
+    pairs = pairs->sibling;
+    result->sibling = nullptr;
+    while (pairs)
+    {
+        Node *next = pairs->sibling;
+        pairs->sibling = nullptr;
+        result = link(result, pairs);
+        pairs = next;
+    }
+    return result;
+}
+
+void PairingHeapCore::push(int value)
+{
+    Node *node = pool.allocate(value);
+    root = root ? link(root, node) : node;
+    ++count;
+}
+
+void PairingHeapCore::pop()
+{
+    if (!root)
+        return;
+
+    Node *old = root;
+    root = combine(old->child);
+    pool.release(old);
+    --count;
+}
+
+const int &PairingHeapCore::top() const
+{
+    return root->key;
+}
+
+void PairingHeapCore::meld(PairingHeapCore &other)
+{
+    if (&other == this || !other.root)
+        return;
+
+    pool.splice(other.pool);
+    root = root ? link(root, other.root) : other.root;
+    count += other.count;
+
+    other.root = nullptr;
+    other.count = 0;
+}
+
+void PairingHeapCore::top_k(std::size_t k, std::vector<int> &out) const
+{
+    // Same frontier walk as HeapCore: take the largest frontier node, then add its children
+    auto smaller = [](const Node *a, const Node *b) { return a->key < b->key; };
+    std::vector<const Node *> frontier;
+    if (root)
+        frontier.push_back(root);
+
+    for (std::size_t taken = 0; taken < k && !frontier.empty(); ++taken)
+    {
+        std::pop_heap(frontier.begin(), frontier.end(), smaller);
+        const Node *node = frontier.back();
+        frontier.pop_back();
+        out.push_back(node->key);
+        for (const Node *child = node->child; child; child = child->sibling)
+        {
+            frontier.push_back(child);
+            std::push_heap(frontier.begin(), frontier.end(), smaller);
+        }
+    }
+}
+
+void PairingHeapCore::pop_k(std::size_t k, std::vector<int> &out)
+{
+    for (; k > 0 && root; --k)
+    {
+        out.push_back(root->key);
+        pop();
+    }
+}
+
+const PairingHeapCore::Node *PairingHeapCore::getRoot() const
+{
+    return root;
+}
+
+std::size_t PairingHeapCore::size() const
+{
+    return count;
+}
+
+bool PairingHeapCore::empty() const
+{
+    return count == 0;
+}
+
+void PairingHeapCore::clear()
+{
+    pool.clear(); // Nodes hold only ints and pointers, nothing to destroy
+    root = nullptr;
+    count = 0;
+}
+
+#endif // PAIRING_HEAP_CORE_H
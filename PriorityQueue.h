@@ -5,138 +5,332 @@
 #include <vector>
 #include <iostream>
 #include <cmath>
+#include "FontCache.h"
+#include "RetainedScene.h"
+#include "TreeLayout.h"
+#include "HeapCore.h"
+#include "PairingHeapCore.h"
+#include "RadixHeapCore.h"
 
 class PriorityQueue
 {
+public:
+    // Storage behind the queue, chosen at construction
+    enum class Backend
+    {
+        ArrayHeap,   // Binary heap in an array: compact, fastest push and pop
+        PairingHeap, // Pointer-based pairing heap: O(1) meld with another pairing-heap queue
+        RadixHeap    // Buckets by key bits: O(1) push, for keys enqueued at most as large as the last dequeued
+    };
+
 private:
-    std::vector<int> pq; // Using a vector to represent the heap-based priority queue
-    sf::Font font;       // Font for drawing numbers
+    Backend backend;
+    HeapCore<2> pq;              // Max-heap of the priorities; binary to match the tree layout
+    PairingHeapCore pairing;     // Used instead of pq by the pairing heap backend
+    RadixHeapCore radix;         // Used instead of pq by the radix heap backend
+    TreeLayout layout;           // Tidy positions of the tree, indexed like pq (or drawnKeys)
+    RetainedScene scene;         // Cached geometry of the visible nodes
+    std::vector<int> visibleIds; // Scratch list for viewport queries
+
+    // The other backends are drawn as binary trees built for the purpose, with the
+    // layout ids handed out afresh whenever the scene is rebuilt after a change:
+    //  - pairing heap: its child/sibling tree, left is the first child, right the next sibling
+    //  - radix heap: each bucket runs down to the right, and the next bucket hangs to the left
+    std::vector<int> drawnKeys; // Key of each layout id
+    std::vector<std::pair<const PairingHeapCore::Node *, int>> pending; // Scratch stack for walking the pairing heap
+    bool relink = false;
+
+    // Record a change of the contents in the layout and the scene
+    void changed()
+    {
+        if (backend == Backend::ArrayHeap)
+            layout.setArrayTree(pq.size());
+        else
+            relink = true;
+        scene.invalidate();
+    }
 
-    // Helper function to maintain the max-heap property by bubbling up
-    void bubbleUp(int index)
+    // Number the pairing heap's nodes and record their child and sibling links
+    void relinkPairing()
     {
-        while (index > 0)
+        const PairingHeapCore::Node *root = pairing.getRoot();
+        if (root)
         {
-            int parentIndex = (index - 1) / 2;
-            if (pq[parentIndex] < pq[index])
+            drawnKeys.push_back(root->key);
+            pending.push_back(std::make_pair(root, 0));
+        }
+        while (!pending.empty())
+        {
+            const PairingHeapCore::Node *node = pending.back().first;
+            int id = pending.back().second;
+            pending.pop_back();
+
+            int child = TreeLayout::None;
+            int sibling = TreeLayout::None;
+            if (node->child)
             {
-                std::swap(pq[parentIndex], pq[index]);
-                index = parentIndex;
+                child = static_cast<int>(drawnKeys.size());
+                drawnKeys.push_back(node->child->key);
+                pending.push_back(std::make_pair(node->child, child));
             }
-            else
+            if (node->sibling)
             {
-                break;
+                sibling = static_cast<int>(drawnKeys.size());
+                drawnKeys.push_back(node->sibling->key);
+                pending.push_back(std::make_pair(node->sibling, sibling));
             }
+            layout.setChildren(id, child, sibling);
         }
     }
 
-    // Helper function to maintain the max-heap property by bubbling down
-    void bubbleDown(int index)
+    // Number the radix heap's keys bucket by bucket and chain them up
+    void relinkRadix()
     {
-        int leftChildIndex = 2 * index + 1;
-        int rightChildIndex = 2 * index + 2;
-        int largest = index;
-
-        if (leftChildIndex < pq.size() && pq[leftChildIndex] > pq[largest])
+        int previousFirst = TreeLayout::None; // First key of the previous non-empty bucket
+        for (int bucket = 0; bucket < RadixHeapCore::getBucketCount(); ++bucket)
         {
-            largest = leftChildIndex;
-        }
+            std::size_t keys = radix.bucketSize(bucket);
+            if (keys == 0)
+                continue;
 
-        if (rightChildIndex < pq.size() && pq[rightChildIndex] > pq[largest])
-        {
-            largest = rightChildIndex;
+            int first = static_cast<int>(drawnKeys.size());
+            for (std::size_t i = 0; i < keys; ++i)
+            {
+                drawnKeys.push_back(radix.key(bucket, i));
+                layout.setChildren(first + static_cast<int>(i), TreeLayout::None,
+                                   i + 1 < keys ? first + static_cast<int>(i) + 1 : TreeLayout::None);
+            }
+            if (previousFirst != TreeLayout::None)
+                layout.setChildren(previousFirst, first, previousFirst + 1 < first ? previousFirst + 1 : TreeLayout::None);
+            previousFirst = first;
         }
+    }
 
-        if (largest != index)
+    void relinkTree()
+    {
+        layout.clear();
+        drawnKeys.clear();
+        if (backend == Backend::PairingHeap)
+            relinkPairing();
+        else
+            relinkRadix();
+        layout.setRoot(drawnKeys.empty() ? TreeLayout::None : 0);
+        relink = false;
+    }
+
+    // Move every element out into values, in no particular order, in O(n)
+    void drain(std::vector<int> &values)
+    {
+        switch (backend)
         {
-            std::swap(pq[index], pq[largest]);
-            bubbleDown(largest); // Recursively bubble down the swapped element
+        case Backend::ArrayHeap:
+            for (std::size_t i = 0; i < pq.size(); ++i)
+            {
+                values.push_back(pq[i]);
+            }
+            pq = HeapCore<2>();
+            break;
+        case Backend::PairingHeap:
+            pending.clear();
+            if (pairing.getRoot())
+                pending.push_back(std::make_pair(pairing.getRoot(), 0));
+            while (!pending.empty())
+            {
+                const PairingHeapCore::Node *node = pending.back().first;
+                pending.pop_back();
+                values.push_back(node->key);
+                if (node->child)
+                    pending.push_back(std::make_pair(node->child, 0));
+                if (node->sibling)
+                    pending.push_back(std::make_pair(node->sibling, 0));
+            }
+            pairing.clear();
+            break;
+        case Backend::RadixHeap:
+            for (int bucket = 0; bucket < RadixHeapCore::getBucketCount(); ++bucket)
+            {
+                for (std::size_t i = 0; i < radix.bucketSize(bucket); ++i)
+                {
+                    values.push_back(radix.key(bucket, i));
+                }
+            }
+            radix.clear();
+            break;
         }
+        changed();
     }
 
 public:
-    // Constructor: Load font once
-    PriorityQueue()
+    explicit PriorityQueue(Backend backend = Backend::ArrayHeap) : backend(backend), layout(70.f, 150.f), scene(true) {}
+
+    Backend getBackend() const
     {
-        if (!font.loadFromFile("Arial.ttf"))
-        {
-            std::cerr << "Error loading font!" << std::endl;
-        }
+        return backend;
     }
 
     // Enqueues an element to the priority queue (max-heap)
     void enqueue(int value)
     {
-        pq.push_back(value);     // Add the new element at the end
-        bubbleUp(pq.size() - 1); // Bubble it up to maintain heap property
+        switch (backend)
+        {
+        case Backend::ArrayHeap:
+            pq.push(value); // Add it at the end and bubble it up to maintain the heap property
+            break;
+        case Backend::PairingHeap:
+            pairing.push(value); // Link it with the root
+            break;
+        case Backend::RadixHeap:
+            radix.push(value); // Drop it in the bucket its bits pick
+            break;
+        }
+        changed();
     }
 
     // Dequeues the highest priority element (root of the max-heap)
     void dequeue()
     {
-        if (!pq.empty())
+        if (isEmpty())
+            return;
+
+        switch (backend)
         {
-            pq[0] = pq.back(); // Replace the root with the last element
-            pq.pop_back();     // Remove the last element
-            bubbleDown(0);     // Bubble the new root down to restore heap property
+        case Backend::ArrayHeap:
+            pq.pop(); // Replace the root with the last element and bubble it down
+            break;
+        case Backend::PairingHeap:
+            pairing.pop(); // Pair up the root's children into the new tree
+            break;
+        case Backend::RadixHeap:
+            radix.pop(); // Spread the next bucket over the lower ones once bucket 0 runs out
+            break;
+        }
+        changed();
+    }
+
+    // Enqueues a batch of elements, with one O(n) heapify for the array heap
+    template <typename InputIt>
+    void build(InputIt first, InputIt last)
+    {
+        if (backend == Backend::ArrayHeap)
+        {
+            pq.build(first, last);
+        }
+        else
+        {
+            for (; first != last; ++first)
+            {
+                if (backend == Backend::PairingHeap)
+                    pairing.push(*first);
+                else
+                    radix.push(*first);
+            }
+        }
+        changed();
+    }
+
+    // Moves every element of other into this queue, leaving other empty. O(1) when
+    // both use the pairing heap; otherwise other's elements are added as one batch.
+    void meld(PriorityQueue &other)
+    {
+        if (&other == this || other.isEmpty())
+            return;
+
+        if (backend == Backend::PairingHeap && other.backend == Backend::PairingHeap)
+        {
+            pairing.meld(other.pairing);
+        }
+        else
+        {
+            std::vector<int> values;
+            other.drain(values);
+            build(values.begin(), values.end());
+            return; // build and drain recorded the changes
+        }
+        changed();
+        other.changed();
+    }
+
+    // Dequeues the k highest priority elements into out, highest first
+    void pop_k(std::size_t k, std::vector<int> &out)
+    {
+        if (isEmpty() || k == 0)
+            return;
+
+        switch (backend)
+        {
+        case Backend::ArrayHeap:
+            pq.pop_k(k, out);
+            break;
+        case Backend::PairingHeap:
+            pairing.pop_k(k, out);
+            break;
+        case Backend::RadixHeap:
+            radix.pop_k(k, out);
+            break;
+        }
+        changed();
+    }
+
+    // Copies the k highest priority elements into out, highest first, without dequeuing them
+    void top_k(std::size_t k, std::vector<int> &out) const
+    {
+        switch (backend)
+        {
+        case Backend::ArrayHeap:
+            pq.top_k(k, out);
+            break;
+        case Backend::PairingHeap:
+            pairing.top_k(k, out);
+            break;
+        case Backend::RadixHeap:
+            radix.top_k(k, out);
+            break;
         }
     }
 
     // Visualizes the priority queue (draws circles with numbers)
-    void visualize(sf::RenderWindow &window)
+    void visualize(sf::RenderTarget &target)
     {
-        if (pq.empty())
+        if (isEmpty())
             return;
 
-        // Constants to handle position
-        int xStart = window.getSize().x / 2; // Center horizontally
-        int yStart = 40;                     // Starting y-position at the top
-        int nodeSpacing = 100;               // Horizontal spacing between nodes
-        int verticalSpacing = 150;           // Vertical spacing between levels
+        if (scene.needsRebuild(target))
+        {
+            BatchRenderer &batch = scene.rebuild(target);
+            buildScene(batch, target.getSize(), scene.getVisibleArea());
+        }
+        scene.draw(target);
+    }
+
+    // Fills the batch with the circles, numbers and links of the visible part of the heap
+    void buildScene(BatchRenderer &batch, sf::Vector2u targetSize, sf::FloatRect area)
+    {
+        if (relink)
+            relinkTree();
+        layout.update();
+        sf::Vector2f origin(targetSize.x / 2.f, 40.f); // Root centered at the top
 
-        int level = 0;
-        int nodesOnLevel = 1; // Start with 1 node at the root level
+        area.left -= origin.x;
+        area.top -= origin.y;
+        visibleIds.clear();
+        layout.query(area, visibleIds);
 
-        // Loop through all elements in the priority queue (heap)
-        for (int i = 0; i < pq.size(); ++i)
+        for (int i : visibleIds)
         {
-            // Calculate the position of the current node
-            int xPos = xStart - (nodeSpacing * (nodesOnLevel - 1)) / 2 + (i % nodesOnLevel) * nodeSpacing;
-            int yPos = yStart + level * verticalSpacing;
+            sf::Vector2f center = origin + layout.getPosition(i);
 
-            // Draw circle for the current node
-            sf::CircleShape circle(30);               // Radius of 30 for each circle
-            circle.setPosition(xPos - 30, yPos - 30); // Adjust so the circle is centered
-            circle.setFillColor(sf::Color::Magenta);
-            window.draw(circle);
+            // Draw circle for the current node, radius of 30 centered on the position
+            batch.addCircle(center, 30, sf::Color::Magenta);
 
             // Draw the text inside the circle
-            sf::Text text(std::to_string(pq[i]), font, 24);
-            text.setPosition(xPos - 12, yPos - 12); // Center text inside the circle
-            text.setFillColor(sf::Color::White);
-            window.draw(text);
+            int key = backend == Backend::ArrayHeap ? pq[i] : drawnKeys[i];
+            batch.addText(std::to_string(key), FontCache::get(), 24, center - sf::Vector2f(12, 14), sf::Color::White);
 
             // Draw lines connecting the parent to the current node
-            if (i > 0) // Skip if it's the root node
+            int parent = layout.getParent(i);
+            if (parent != TreeLayout::None) // Skip if it's the root node
             {
-                int parentIndex = (i - 1) / 2;
-                int parentX = xStart - (nodeSpacing * (nodesOnLevel - 1)) / 2 + (parentIndex % nodesOnLevel) * nodeSpacing;
-                int parentY = yStart + (parentIndex / nodesOnLevel) * verticalSpacing;
-
-                sf::Vertex line[] =
-                    {
-                        sf::Vertex(sf::Vector2f(xPos, yPos)),
-                        sf::Vertex(sf::Vector2f(parentX, parentY))};
-                line[0].color = sf::Color::White;
-                line[1].color = sf::Color::White;
-                window.draw(line, 2, sf::Lines);
-            }
-
-            // Update for the next node on the same level
-            if ((i + 1) % nodesOnLevel == 0)
-            {
-                level++;
-                nodesOnLevel *= 2; // Double the number of nodes on the next level
+                batch.addLine(center, origin + layout.getPosition(parent), sf::Color::White);
             }
         }
     }
@@ -144,19 +338,43 @@ public:
     // Checks if the priority queue is empty
     bool isEmpty() const
     {
-        return pq.empty();
+        return size() == 0;
+    }
+
+    std::size_t size() const
+    {
+        switch (backend)
+        {
+        case Backend::PairingHeap:
+            return pairing.size();
+        case Backend::RadixHeap:
+            return radix.size();
+        default:
+            return pq.size();
+        }
     }
 
     // Returns the highest priority element (root of the heap)
     int front() const
     {
-        return pq.empty() ? -1 : pq[0];
+        if (isEmpty())
+            return -1;
+
+        switch (backend)
+        {
+        case Backend::PairingHeap:
+            return pairing.top();
+        case Backend::RadixHeap:
+            return radix.top();
+        default:
+            return pq.top();
+        }
     }
 
-    // Returns the lowest priority element (last element in the heap)
+    // Returns the last element in the array heap; the other backends have no last slot, so -1
     int back() const
     {
-        return pq.empty() ? -1 : pq.back();
+        return backend == Backend::ArrayHeap && !pq.empty() ? pq[pq.size() - 1] : -1;
     }
 };
 
@@ -4,17 +4,22 @@
 #include <SFML/Graphics.hpp>
 #include <vector>
 #include <iostream>
+#include "FontCache.h"
+#include "RetainedScene.h"
+#include "QueueCore.h"
 
 class Queue
 {
 private:
-    std::vector<int> queue; // Using vector to represent the queue
+    QueueCore queue;        // Ring buffer, dequeue does not move the other elements
+    RetainedScene scene;    // Cached geometry, rebuilt only after enqueue/dequeue
 
 public:
     // Enqueues an element to the back of the queue
     void enqueue(int value)
     {
-        queue.push_back(value);
+        queue.push(value);
+        scene.invalidate();
     }
 
     // Dequeues the front element of the queue
@@ -22,31 +27,45 @@ public:
     {
         if (!queue.empty())
         {
-            queue.erase(queue.begin());
+            queue.pop();
+            scene.invalidate();
         }
     }
 
+    // Enqueues count values from an array, in order
+    void enqueue_range(const int *values, std::size_t count)
+    {
+        if (count == 0)
+            return;
+        queue.push_range(values, count);
+        scene.invalidate();
+    }
+
+    // Dequeues up to count front elements into out (if not null) and returns how many were removed
+    std::size_t dequeue_n(int *out, std::size_t count)
+    {
+        std::size_t removed = queue.pop_n(out, count);
+        if (removed > 0)
+            scene.invalidate();
+        return removed;
+    }
+
     // Visualizes the queue (draws rectangles with numbers)
-    void visualize(sf::RenderWindow &window)
+    void visualize(sf::RenderTarget &target)
     {
-        for (int i = 0; i < queue.size(); i++)
+        if (scene.needsRebuild(target))
         {
-            sf::RectangleShape rect(sf::Vector2f(50, 50));
-            rect.setPosition(100.0f + i * 60, 100.0f); // Queue is horizontal
-            rect.setFillColor(sf::Color::Green);
-            window.draw(rect);
-
-            // Display the number inside the rectangle
-            sf::Font font;
-            if (!font.loadFromFile("Arial.ttf"))
+            BatchRenderer &batch = scene.rebuild(target);
+            for (int i = 0; i < queue.size(); i++)
             {
-                std::cerr << "Error loading font!" << std::endl;
+                batch.addRectangle(sf::Vector2f(100.0f + i * 60, 100.0f), sf::Vector2f(50, 50), sf::Color::Green); // Queue is horizontal
+
+                // Display the number inside the rectangle
+                batch.addText(std::to_string(queue[i]), FontCache::get(), 20,
+                              sf::Vector2f(115.0f + i * 60, 110.0f), sf::Color::White);
             }
-            sf::Text text(std::to_string(queue[i]), font, 20);
-            text.setPosition(115.0f + i * 60, 110.0f);
-            text.setFillColor(sf::Color::White);
-            window.draw(text);
         }
+        scene.draw(target);
     }
 
     // Checks if the queue is empty
@@ -66,6 +85,12 @@ public:
     {
         return queue.empty() ? -1 : queue.back();
     }
+
+    // Returns the number of elements in the queue
+    std::size_t size() const
+    {
+        return queue.size();
+    }
 };
 
 #endif // QUEUE_H
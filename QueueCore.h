@@ -0,0 +1,144 @@
+#ifndef QUEUE_CORE_H
+#define QUEUE_CORE_H
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+// FIFO of ints in a power-of-two ring buffer that doubles when full.
+class QueueCore
+{
+private:
+    static constexpr std::size_t minCapacity = 16;
+
+    std::vector<int> slots; // slots.size() is the capacity, always a power of two (or 0)
+    std::size_t head;       // Slot of the front element
+    std::size_t count;
+
+    std::size_t mask() const;
+    void grow(std::size_t needed); // Make room for at least needed elements, front moves to slot 0
+
+public:
+    QueueCore();
+
+    void push(int value);
+    void pop(); // Remove the front element; does nothing when empty
+
+    // Append n values from a contiguous array
+    void push_range(const int *values, std::size_t n);
+    // Remove up to n front elements, copying them to out unless it is null; returns how many
+    std::size_t pop_n(int *out, std::size_t n);
+
+    int front() const; // The queue must not be empty
+    int back() const;  // The queue must not be empty
+    int operator[](std::size_t index) const; // index-th element from the front
+    std::size_t size() const;
+    std::size_t capacity() const;
+    bool empty() const;
+};
+
+// ------------------------------------------------------
+// Implementation of QueueCore methods
+
+QueueCore::QueueCore() : head(0), count(0)
+{
+}
+
+std::size_t QueueCore::mask() const
+{
+    return slots.size() - 1;
+}
+
+void QueueCore::grow(std::size_t needed)
+{
+    std::size_t newCapacity = std::max(slots.size(), minCapacity);
+    while (newCapacity < needed)
+    {
+        newCapacity *= 2;
+    }
+
+    // Unwrap into the new buffer: the part from head to the end, then the wrapped part
+    std::vector<int> newSlots(newCapacity);
+    std::size_t firstSpan = std::min(count, slots.size() - head);
+    std::copy(slots.begin() + head, slots.begin() + head + firstSpan, newSlots.begin());
+    std::copy(slots.begin(), slots.begin() + (count - firstSpan), newSlots.begin() + firstSpan);
+
+    slots.swap(newSlots);
+    head = 0;
+}
+
+void QueueCore::push(int value)
+{
+    if (count == slots.size())
+        grow(count + 1);
+    slots[(head + count) & mask()] = value;
+    ++count;
+}
+
+void QueueCore::pop()
+{
+    if (count == 0)
+        return;
+    head = (head + 1) & mask();
+    --count;
+}
+
+void QueueCore::push_range(const int *values, std::size_t n)
+{
+    if (count + n > slots.size())
+        grow(count + n);
+
+    // First span runs up to the end of the buffer, the rest wraps to the start
+    std::size_t tail = (head + count) & mask();
+    std::size_t firstSpan = std::min(n, slots.size() - tail);
+    std::copy(values, values + firstSpan, slots.begin() + tail);
+    std::copy(values + firstSpan, values + n, slots.begin());
+    count += n;
+}
+
+std::size_t QueueCore::pop_n(int *out, std::size_t n)
+{
+    n = std::min(n, count);
+    if (out)
+    {
+        std::size_t firstSpan = std::min(n, slots.size() - head);
+        std::copy(slots.begin() + head, slots.begin() + head + firstSpan, out);
+        std::copy(slots.begin(), slots.begin() + (n - firstSpan), out + firstSpan);
+    }
+    if (n > 0)
+        head = (head + n) & mask();
+    count -= n;
+    return n;
+}
+
+int QueueCore::front() const
+{
+    return slots[head];
+}
+
+int QueueCore::back() const
+{
+    return slots[(head + count - 1) & mask()];
+}
+
+int QueueCore::operator[](std::size_t index) const
+{
+    return slots[(head + index) & mask()];
+}
+
+std::size_t QueueCore::size() const
+{
+    return count;
+}
+
+std::size_t QueueCore::capacity() const
+{
+    return slots.size();
+}
+
+bool QueueCore::empty() const
+{
+    return count == 0;
+}
+
+#endif // QUEUE_CORE_H
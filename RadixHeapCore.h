@@ -0,0 +1,213 @@
+#ifndef RADIX_HEAP_CORE_H
+#define RADIX_HEAP_CORE_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+// Max radix heap of ints for monotone workloads, where no key is pushed above the
+// last key popped: push is O(1) and pop O(log C) amortized over the key range C.
+class RadixHeapCore
+{
+private:
+    static const int bucketCount = 33; // Bucket 0 plus one per bit of a rank
+
+    std::vector<std::uint32_t> buckets[bucketCount]; // Ranks, by the highest bit they differ from last in
+    std::uint32_t last;     // Rank of the top key once popping started, rank 0 before
+    std::uint32_t smallest; // Rank of the top key before popping started
+    bool popping;           // Whether a pop has anchored last since the heap was last empty
+    std::size_t count;
+
+    static std::uint32_t rank(int key); // Larger keys get smaller ranks
+    static int keyOf(std::uint32_t rank);
+    int bucketOf(std::uint32_t rank) const;
+    void refill();                  // Refill bucket 0 from the first non-empty bucket
+    void rebucket(std::uint32_t r); // Make r the new last, for a push that breaks monotonicity
+
+public:
+    RadixHeapCore();
+
+    void push(int value);
+    void pop();             // Remove the maximum; does nothing when empty
+    int top() const;        // The maximum; the heap must not be empty
+
+    // Append the min(k, size()) largest keys to out in descending order, leaving the
+    // heap as is. Only the buckets holding those keys are looked at.
+    void top_k(std::size_t k, std::vector<int> &out) const;
+    // Same, but also remove them from the heap
+    void pop_k(std::size_t k, std::vector<int> &out);
+
+    // Buckets in order, for drawing the heap and for moving its keys out
+    static int getBucketCount();
+    std::size_t bucketSize(int bucket) const;
+    int key(int bucket, std::size_t index) const;
+
+    std::size_t size() const;
+    bool empty() const;
+    void clear();
+};
+
+// ------------------------------------------------------
+// Implementation of RadixHeapCore methods
+
+RadixHeapCore::RadixHeapCore() : last(0), smallest(0), popping(false), count(0)
+{
+}
+
+std::uint32_t RadixHeapCore::rank(int key)
+{
+    return ~(static_cast<std::uint32_t>(key) ^ 0x80000000u); // Flip to unsigned order, then reverse it
+}
+
+int RadixHeapCore::keyOf(std::uint32_t rank)
+{
+    return static_cast<int>(~rank ^ 0x80000000u);
+}
+
+int RadixHeapCore::bucketOf(std::uint32_t r) const
+{
+    std::uint32_t differing = r ^ last;
+    return differing == 0 ? 0 : 32 - __builtin_clz(differing);
+}
+
+void RadixHeapCore::refill()
+{
+    int first = 1;
+    while (buckets[first].empty())
+    {
+        ++first;
+    }
+
+    // The smallest rank there becomes last; relative to it, every other rank in the
+    // bucket differs in a lower bit, so they all move down
+    std::vector<std::uint32_t> &source = buckets[first];
+    last = *std::min_element(source.begin(), source.end());
+    for (std::uint32_t r : source)
+    {
+        buckets[bucketOf(r)].push_back(r);
+    }
+    source.clear();
+}
+
+void RadixHeapCore::rebucket(std::uint32_t r)
+{
+    std::vector<std::uint32_t> ranks;
+    ranks.reserve(count);
+    for (std::vector<std::uint32_t> &bucket : buckets)
+    {
+        ranks.insert(ranks.end(), bucket.begin(), bucket.end());
+        bucket.clear();
+    }
+
+    last = r;
+    for (std::uint32_t other : ranks)
+    {
+        buckets[bucketOf(other)].push_back(other);
+    }
+}
+
+void RadixHeapCore::push(int value)
+{
+    std::uint32_t r = rank(value);
+    if (!popping)
+        smallest = count == 0 ? r : std::min(smallest, r); // Buckets stay relative to rank 0 until the first pop
+    else if (r < last)
+        rebucket(r); // Larger than the last popped key
+
+    buckets[bucketOf(r)].push_back(r);
+    ++count;
+}
+
+void RadixHeapCore::pop()
+{
+    if (count == 0)
+        return;
+
+    if (!popping)
+    {
+        // Anchor last at the top key, found in the first non-empty bucket
+        popping = true;
+        if (buckets[0].empty())
+            refill();
+    }
+
+    buckets[0].pop_back();
+    --count;
+    if (count == 0)
+    {
+        popping = false;
+        last = 0;
+    }
+    else if (buckets[0].empty())
+        refill();
+}
+
+int RadixHeapCore::top() const
+{
+    return keyOf(popping ? last : smallest);
+}
+
+void RadixHeapCore::top_k(std::size_t k, std::vector<int> &out) const
+{
+    std::vector<std::uint32_t> ranks;
+    for (int bucket = 0; bucket < bucketCount && k > 0; ++bucket)
+    {
+        // Whole buckets come out in order of their ranks; only the last one needed is cut short
+        ranks.assign(buckets[bucket].begin(), buckets[bucket].end());
+        std::size_t taken = std::min(k, ranks.size());
+        std::partial_sort(ranks.begin(), ranks.begin() + taken, ranks.end());
+        for (std::size_t i = 0; i < taken; ++i)
+        {
+            out.push_back(keyOf(ranks[i]));
+        }
+        k -= taken;
+    }
+}
+
+void RadixHeapCore::pop_k(std::size_t k, std::vector<int> &out)
+{
+    for (; k > 0 && count > 0; --k)
+    {
+        out.push_back(top());
+        pop();
+    }
+}
+
+int RadixHeapCore::getBucketCount()
+{
+    return bucketCount;
+}
+
+std::size_t RadixHeapCore::bucketSize(int bucket) const
+{
+    return buckets[bucket].size();
+}
+
+int RadixHeapCore::key(int bucket, std::size_t index) const
+{
+    return keyOf(buckets[bucket][index]);
+}
+
+std::size_t RadixHeapCore::size() const
+{
+    return count;
+}
+
+bool RadixHeapCore::empty() const
+{
+    return count == 0;
+}
+
+void RadixHeapCore::clear()
+{
+    for (std::vector<std::uint32_t> &bucket : buckets)
+    {
+        bucket.clear();
+    }
+    last = 0;
+    popping = false;
+    count = 0;
+}
+
+#endif // RADIX_HEAP_CORE_H
@@ -5,6 +5,15 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include "RetainedScene.h"
+#include "FontCache.h"
+#include "TreeLayout.h"
+#include "NodePool.h"
+#include "IteratorRange.h"
 
 using namespace std;
 
@@ -20,36 +29,203 @@ private:
     struct Node
     {
         int value;
+        int id; // Key of the node in the layout
         Color color;
+        int size; // Nodes in the subtree, kept up to date while order statistics are on
         Node *left, *right, *parent;
 
-        Node(int val)
-            : value(val), color(Color::RED), left(nullptr), right(nullptr), parent(nullptr) {}
+        Node(int val, int nodeId)
+            : value(val), id(nodeId), color(Color::RED), size(1), left(nullptr), right(nullptr), parent(nullptr) {}
     };
 
     Node *root;
+    std::size_t count;
+
+    // New nodes come from pool. Nodes taken over from other trees by join, split or
+    // the set operations stay where they are, so the pools they live in are kept
+    // alive in borrowed; a pool is only rewound when no other tree refers to it.
+    std::shared_ptr<NodePool<Node>> pool;
+    std::vector<std::shared_ptr<NodePool<Node>>> borrowed;
+
+    std::vector<Node *> nodes;   // Every node, indexed by id; nullptr for ids of erased nodes
+    std::vector<int> freeIds;    // Ids of erased nodes, reused by later inserts
+    bool layoutStale;            // A bulk operation reshaped the tree; ids and layout are redone before drawing
+    TreeLayout layout;           // Tidy positions, updated along insertion paths and rotations only
+    RetainedScene scene;         // Cached geometry of the visible nodes
+    std::vector<int> visibleIds; // Scratch lists for viewport queries
+    std::vector<int> collapsedIds;
+    bool levelOfDetail;          // Draw narrow subtrees as a single glyph
+    bool orderStatistics;        // Keep subtree sizes for select and rank
+
+    static constexpr float collapseWidth = 40.f; // On-screen width in pixels below which a subtree collapses
+    static const int parallelBlackHeight = 10;   // Set operations on smaller subtrees stay on one thread
+    static const int maxHeight = 130;            // Nodes on the longest path down a subtree of any tree that fits in memory
+
+    // A detached subtree and its black height (black nodes on a path down, the root included)
+    struct Subtree
+    {
+        Node *root;
+        int blackHeight;
+    };
 
     // Helper functions for balancing and rotating
     void rotateLeft(Node *&root, Node *&pt);
     void rotateRight(Node *&root, Node *&pt);
     void fixViolation(Node *&root, Node *&pt);
-    void inorderHelper(Node *root, std::vector<int> &values);
-    void visualizeNode(sf::RenderWindow &window, Node *node, int x, int y, int offset);
-    void visualizeEdges(sf::RenderWindow &window, Node *node, int x, int y, int offset);
+    void fixErase(Node *x, Node *xParent);
+    void transplant(Node *u, Node *v); // Put v where u hangs in the tree
+    static bool isRed(const Node *node); // Null leaves count as black
+    static int sizeOf(const Node *node);
+    void updateSize(Node *node);       // Recompute a node's size from its children's
+    void recomputeSizes();             // Every size, bottom-up, when order statistics are turned on
+    static Node *leftmost(Node *node);    // Smallest node of a subtree
+    static Node *rightmost(Node *node);   // Largest node of a subtree
+    static Node *successor(Node *node);   // Next node in order, or nullptr
+    static Node *predecessor(Node *node); // Previous node in order, or nullptr
+    std::size_t countBelow(int value, bool inclusive) const; // Values below (or not above) value
+
+    // Layout bookkeeping, skipped while the layout is stale
+    void relinkNode(Node *node); // The node's children changed
+    void relinkRoot();           // The root changed
+    void relinkLayout();         // Renumber every node and rebuild the layout links, after a bulk operation
+
+    // Join-based bulk operations on detached subtrees. They touch neither the layout
+    // nor the pools, so the halves of the set operations can run on separate threads.
+    static Node *attach(Node *node, Node *left, Node *right); // Set a node's children, their parent and its size
+    static Node *rotatedLeft(Node *node);  // Rotations for detached subtrees, returning the new subtree root
+    static Node *rotatedRight(Node *node);
+    static Subtree childOf(const Subtree &tree, Node *child); // A child of the root as a subtree of its own
+    static Subtree joinRight(Subtree left, Node *middle, Subtree right); // The left tree is taller
+    static Subtree joinLeft(Subtree left, Node *middle, Subtree right);  // The right tree is taller
+    static Subtree join(Subtree left, Node *middle, Subtree right);
+    static Subtree concat(Subtree left, Subtree right);
+    static Subtree splitLast(Subtree tree, Node *&last); // Detach the largest node
+    static void split(Subtree tree, int key, bool inclusive, Subtree &less, Subtree &rest);
+    enum class SetOperation
+    {
+        Unite,
+        Intersect,
+        Subtract
+    };
+    static Subtree combine(SetOperation operation, Subtree a, Subtree b, std::vector<Node *> &dropped, int threads);
+    static void collect(Node *root, std::vector<Node *> &out); // Every node of a subtree
+    static int parallelThreads();
+
+    Subtree takeTree(RedBlackTree &other); // Take over other's nodes and their pools, leaving other empty
+    void setTree(Subtree tree, const std::vector<Node *> &dropped); // Install a bulk operation's result
+
+    // Iterative searches from the root
+    Node *lowerBoundNode(int value) const; // First node not below value
+    Node *upperBoundNode(int value) const; // First node above value
+    void visualizeNode(BatchRenderer &batch, Node *node, sf::Vector2f origin);
+    void visualizeEdge(BatchRenderer &batch, Node *node, sf::Vector2f origin);
+    void visualizeSubtree(BatchRenderer &batch, Node *node, sf::Vector2f origin, float unitsPerPixel);
 
 public:
+    // Bidirectional in-order iterator over the values. Steps follow the parent
+    // pointers, so an iterator is just a node pointer and walking the whole tree
+    // allocates nothing. Insert and erase leave iterators to other values valid.
+    class const_iterator
+    {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef int value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const int *pointer;
+        typedef const int &reference;
+
+        const_iterator() : node(nullptr), tree(nullptr) {}
+
+        reference operator*() const { return node->value; }
+        pointer operator->() const { return &node->value; }
+
+        const_iterator &operator++()
+        {
+            node = successor(node);
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+        const_iterator &operator--()
+        {
+            node = node != nullptr ? predecessor(node) : rightmost(tree->root); // end() steps back to the largest value
+            return *this;
+        }
+        const_iterator operator--(int)
+        {
+            const_iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator &other) const { return node == other.node; }
+        bool operator!=(const const_iterator &other) const { return node != other.node; }
+
+    private:
+        friend class RedBlackTree;
+        const_iterator(Node *node, const RedBlackTree *tree) : node(node), tree(tree) {}
+
+        Node *node; // nullptr past the end
+        const RedBlackTree *tree;
+    };
+    typedef const_iterator iterator;
+
     RedBlackTree();
+
+    RedBlackTree(const RedBlackTree &) = delete;
+    RedBlackTree &operator=(const RedBlackTree &) = delete;
+
     void insert(int value);
+    bool erase(int value); // Remove one occurrence of value; false if there is none
+    void clear();          // Remove every node at once, keeping the pool's blocks for new ones
+
+    // Join-based bulk operations. Each runs in O(log n) (split, join) or in
+    // O(m log(n/m + 1)) work for trees of m <= n values (set operations), with the
+    // two halves of large set operations running in parallel. They keep subtree
+    // sizes, so they turn order statistics on. Trees passed in end up empty; the
+    // layout of the result is rebuilt the next time it is drawn.
+    void split(int key, RedBlackTree &right);                    // Move the values not below key into right
+    void join(RedBlackTree &left, int key, RedBlackTree &right); // Become left, key, right; needs left <= key <= right
+    void unite(RedBlackTree &other);     // Add every value of other, duplicates included
+    void intersect(RedBlackTree &other); // Keep only the values that other contains too
+    void subtract(RedBlackTree &other);  // Remove every value that other contains
+
+    // Lookups in O(log n); each returns an iterator to the value, or end() if there is none
+    const_iterator find(int value) const;        // A value equal to value
+    const_iterator lower_bound(int value) const; // The smallest value not below value
+    const_iterator upper_bound(int value) const; // The smallest value above value
+    std::size_t size() const;
+
+    // Order statistics, O(log n) while they are on and an in-order walk otherwise
+    void setOrderStatistics(bool enabled); // Turning them on recomputes every subtree size in O(n)
+    const int *select(std::size_t k) const;   // The k-th smallest value, from 0; nullptr if k >= size()
+    std::size_t rank(int value) const;        // Number of values below value
+    std::size_t count_range(int lo, int hi) const; // Number of values in [lo, hi]
+
     void insertHelper(Node *&root, Node *&pt);
-    void display(sf::RenderWindow &window);
+    void display(sf::RenderTarget &target);
+    void setLevelOfDetail(bool enabled); // Collapse subtrees too narrow to read
     void inorderTraversal();
 
+    const_iterator begin() const;
+    const_iterator end() const;
+    IteratorRange<const_iterator> range(int lo, int hi) const; // The values in [lo, hi], in order
+
     // Utility functions
     Node *getRoot() { return root; }
 };
 
 // Constructor to initialize the Red-Black Tree
-RedBlackTree::RedBlackTree() : root(nullptr) {}
+RedBlackTree::RedBlackTree()
+    : root(nullptr), count(0), pool(std::make_shared<NodePool<Node>>()), layoutStale(false), layout(50.f, 60.f), scene(true),
+      levelOfDetail(true), orderStatistics(true)
+{
+    FontCache::warmGlyphs(20); // Node labels use the shared font at size 20
+}
 
 void RedBlackTree::rotateLeft(Node *&root, Node *&pt)
 {
@@ -78,6 +254,18 @@ void RedBlackTree::rotateLeft(Node *&root, Node *&pt)
 
     ptRight->left = pt;
     pt->parent = ptRight;
+
+    // pt is now below ptRight, so its size is needed first
+    updateSize(pt);
+    updateSize(ptRight);
+
+    // Only the two rotated nodes and the parent above them changed shape
+    relinkNode(pt);
+    relinkNode(ptRight);
+    if (ptRight->parent == nullptr)
+        relinkRoot();
+    else
+        relinkNode(ptRight->parent);
 }
 
 void RedBlackTree::rotateRight(Node *&root, Node *&pt)
@@ -107,6 +295,17 @@ void RedBlackTree::rotateRight(Node *&root, Node *&pt)
 
     ptLeft->right = pt;
     pt->parent = ptLeft;
+
+    updateSize(pt);
+    updateSize(ptLeft);
+
+    // Only the two rotated nodes and the parent above them changed shape
+    relinkNode(pt);
+    relinkNode(ptLeft);
+    if (ptLeft->parent == nullptr)
+        relinkRoot();
+    else
+        relinkNode(ptLeft->parent);
 }
 
 // Function to fix violations of Red-Black Tree properties
@@ -178,133 +377,1101 @@ void RedBlackTree::fixViolation(Node *&root, Node *&pt)
 // Helper function to insert a new node in the Red-Black Tree
 void RedBlackTree::insert(int value)
 {
-    Node *pt = new Node(value);
+    int id = TreeLayout::None; // Handed out by relinkLayout while the layout is stale
+    if (!layoutStale && freeIds.empty())
+    {
+        id = static_cast<int>(nodes.size());
+        nodes.push_back(nullptr);
+    }
+    else if (!layoutStale)
+    {
+        id = freeIds.back(); // The layout re-links the id as the node goes in
+        freeIds.pop_back();
+    }
+
+    Node *pt = pool->allocate(value, id);
+    ++count;
+    if (!layoutStale)
+    {
+        nodes[id] = pt;
+        layout.updateLinks(pt);
+    }
     insertHelper(root, pt);
     fixViolation(root, pt);
+    scene.invalidate(); // Insertion and its rotations change the drawing
+}
+
+void RedBlackTree::clear()
+{
+    // Nodes own nothing, so there is nothing to destroy one by one. A pool that other
+    // trees still hold nodes in is left to them.
+    if (pool.use_count() == 1)
+        pool->clear();
+    else
+        pool = std::make_shared<NodePool<Node>>();
+    borrowed.clear();
+
+    nodes.clear();
+    freeIds.clear();
+    root = nullptr;
+    count = 0;
+    layoutStale = false;
+    layout.clear();
+    scene.invalidate();
 }
 
-// Recursive function to insert a node into the Red-Black Tree
+void RedBlackTree::relinkNode(Node *node)
+{
+    if (!layoutStale)
+        layout.updateLinks(node);
+}
+
+void RedBlackTree::relinkRoot()
+{
+    if (!layoutStale)
+        layout.setRoot(root ? root->id : TreeLayout::None);
+}
+
+void RedBlackTree::relinkLayout()
+{
+    layout.clear();
+    nodes.clear();
+    freeIds.clear();
+    for (Node *node = leftmost(root); node != nullptr; node = successor(node))
+    {
+        node->id = static_cast<int>(nodes.size());
+        nodes.push_back(node);
+    }
+    for (Node *node : nodes)
+    {
+        layout.updateLinks(node);
+    }
+    layoutStale = false;
+    relinkRoot();
+}
+
+// Walk down from the root and hang the new node from the last node on the way, in
+// a loop, so the stack does not grow with the height of the tree
 void RedBlackTree::insertHelper(Node *&root, Node *&pt)
 {
     if (root == nullptr)
     {
         root = pt;
+        relinkRoot();
         return;
     }
 
-    if (pt->value < root->value)
+    Node *above = root;
+    while (true)
+    {
+        if (orderStatistics)
+            ++above->size; // pt ends up somewhere below
+
+        Node *&link = pt->value < above->value ? above->left : above->right;
+        if (link == nullptr)
+        {
+            link = pt;
+            pt->parent = above;
+            relinkNode(above);
+            return;
+        }
+        above = link;
+    }
+}
+
+bool RedBlackTree::isRed(const Node *node)
+{
+    return node != nullptr && node->color == Color::RED;
+}
+
+void RedBlackTree::transplant(Node *u, Node *v)
+{
+    if (u->parent == nullptr)
+    {
+        root = v;
+        relinkRoot();
+    }
+    else
+    {
+        if (u == u->parent->left)
+            u->parent->left = v;
+        else
+            u->parent->right = v;
+        relinkNode(u->parent);
+    }
+
+    if (v != nullptr)
+        v->parent = u->parent;
+}
+
+bool RedBlackTree::erase(int value)
+{
+    Node *z = lowerBoundNode(value);
+    if (z == nullptr || z->value != value)
+        return false;
+
+    // y is the node that leaves its place: z itself, or z's successor when z has two
+    // children. x moves into y's place; it may be a null leaf, hence xParent.
+    Node *y = z;
+    Color removedColor = y->color;
+    Node *x;
+    Node *xParent;
+
+    if (z->left == nullptr)
+    {
+        x = z->right;
+        xParent = z->parent;
+        transplant(z, z->right);
+    }
+    else if (z->right == nullptr)
     {
-        if (root->left == nullptr)
+        x = z->left;
+        xParent = z->parent;
+        transplant(z, z->left);
+    }
+    else
+    {
+        y = z->right;
+        while (y->left != nullptr)
+        {
+            y = y->left;
+        }
+        removedColor = y->color;
+        x = y->right;
+
+        if (y->parent == z)
         {
-            root->left = pt;
-            pt->parent = root;
+            xParent = y;
         }
         else
         {
-            insertHelper(root->left, pt);
+            xParent = y->parent;
+            transplant(y, y->right);
+            y->right = z->right;
+            y->right->parent = y;
         }
+
+        transplant(z, y);
+        y->left = z->left;
+        y->left->parent = y;
+        y->color = z->color;
+        relinkNode(y);
     }
-    else
+
+    // Every node from where the removal happened up to the root lost one descendant
+    if (orderStatistics)
+    {
+        for (Node *node = xParent; node != nullptr; node = node->parent)
+        {
+            updateSize(node);
+        }
+    }
+
+    // Removing a black node left one path short of a black node
+    if (removedColor == Color::BLACK)
+        fixErase(x, xParent);
+
+    if (!layoutStale)
+    {
+        nodes[z->id] = nullptr;
+        freeIds.push_back(z->id);
+    }
+    pool->release(z);
+    --count;
+    scene.invalidate();
+    return true;
+}
+
+// Function to restore the Red-Black Tree properties after an erase: x carries an
+// extra black that moves up the tree until a red node or a rotation absorbs it
+void RedBlackTree::fixErase(Node *x, Node *xParent)
+{
+    while (x != root && !isRed(x))
     {
-        if (root->right == nullptr)
+        if (x == xParent->left)
         {
-            root->right = pt;
-            pt->parent = root;
+            Node *sibling = xParent->right;
+
+            if (isRed(sibling))
+            {
+                sibling->color = Color::BLACK;
+                xParent->color = Color::RED;
+                rotateLeft(root, xParent);
+                sibling = xParent->right;
+            }
+
+            if (!isRed(sibling->left) && !isRed(sibling->right))
+            {
+                sibling->color = Color::RED;
+                x = xParent;
+                xParent = x->parent;
+            }
+            else
+            {
+                if (!isRed(sibling->right))
+                {
+                    sibling->left->color = Color::BLACK;
+                    sibling->color = Color::RED;
+                    rotateRight(root, sibling);
+                    sibling = xParent->right;
+                }
+
+                sibling->color = xParent->color;
+                xParent->color = Color::BLACK;
+                sibling->right->color = Color::BLACK;
+                rotateLeft(root, xParent);
+                x = root;
+            }
         }
         else
         {
-            insertHelper(root->right, pt);
+            Node *sibling = xParent->left;
+
+            if (isRed(sibling))
+            {
+                sibling->color = Color::BLACK;
+                xParent->color = Color::RED;
+                rotateRight(root, xParent);
+                sibling = xParent->left;
+            }
+
+            if (!isRed(sibling->left) && !isRed(sibling->right))
+            {
+                sibling->color = Color::RED;
+                x = xParent;
+                xParent = x->parent;
+            }
+            else
+            {
+                if (!isRed(sibling->left))
+                {
+                    sibling->right->color = Color::BLACK;
+                    sibling->color = Color::RED;
+                    rotateLeft(root, sibling);
+                    sibling = xParent->left;
+                }
+
+                sibling->color = xParent->color;
+                xParent->color = Color::BLACK;
+                sibling->left->color = Color::BLACK;
+                rotateRight(root, xParent);
+                x = root;
+            }
         }
     }
+
+    if (x != nullptr)
+        x->color = Color::BLACK;
 }
 
-// In-order traversal to get values for visualization
-void RedBlackTree::inorderTraversal()
+RedBlackTree::Node *RedBlackTree::lowerBoundNode(int value) const
 {
-    std::vector<int> values;
-    inorderHelper(root, values);
-    for (int val : values)
+    Node *result = nullptr;
+    for (Node *node = root; node != nullptr;)
     {
-        std::cout << val << " ";
+        if (node->value < value)
+        {
+            node = node->right;
+        }
+        else
+        {
+            result = node; // A candidate; a smaller one may be on the left
+            node = node->left;
+        }
     }
-    std::cout << std::endl;
+    return result;
 }
 
-void RedBlackTree::inorderHelper(Node *root, std::vector<int> &values)
+RedBlackTree::Node *RedBlackTree::upperBoundNode(int value) const
 {
-    if (root == nullptr)
+    Node *result = nullptr;
+    for (Node *node = root; node != nullptr;)
     {
-        return;
+        if (node->value <= value)
+        {
+            node = node->right;
+        }
+        else
+        {
+            result = node;
+            node = node->left;
+        }
     }
-    inorderHelper(root->left, values);
-    values.push_back(root->value);
-    inorderHelper(root->right, values);
+    return result;
 }
 
-// Function to visualize the tree structure using SFML
-void RedBlackTree::visualizeNode(sf::RenderWindow &window, Node *node, int x, int y, int offset)
+RedBlackTree::const_iterator RedBlackTree::find(int value) const
 {
-    if (node == nullptr)
-        return;
+    Node *node = lowerBoundNode(value);
+    return const_iterator(node != nullptr && node->value == value ? node : nullptr, this);
+}
+
+RedBlackTree::const_iterator RedBlackTree::lower_bound(int value) const
+{
+    return const_iterator(lowerBoundNode(value), this);
+}
+
+RedBlackTree::const_iterator RedBlackTree::upper_bound(int value) const
+{
+    return const_iterator(upperBoundNode(value), this);
+}
+
+std::size_t RedBlackTree::size() const
+{
+    return count;
+}
+
+int RedBlackTree::sizeOf(const Node *node)
+{
+    return node != nullptr ? node->size : 0;
+}
 
-    sf::CircleShape shape(20);
-    shape.setFillColor(node->color == Color::RED ? sf::Color::Red : sf::Color::Black);
-    shape.setPosition(x, y);
-    window.draw(shape);
+void RedBlackTree::updateSize(Node *node)
+{
+    if (orderStatistics)
+        node->size = 1 + sizeOf(node->left) + sizeOf(node->right);
+}
 
-    sf::Font font;
-    if (!font.loadFromFile("Arial.ttf"))
+void RedBlackTree::recomputeSizes()
+{
+    // Post-order: a node comes after both of its subtrees
+    Node *previous = nullptr;
+    Node *node = root;
+    while (node != nullptr)
     {
-        std::cerr << "Error loading font!" << std::endl;
-        exit(EXIT_FAILURE);
+        if (previous == node->parent && node->left != nullptr)
+        {
+            previous = node;
+            node = node->left; // Coming down: left subtree first
+        }
+        else if (previous != node->right && node->right != nullptr && (previous == node->parent || previous == node->left))
+        {
+            previous = node;
+            node = node->right; // Left subtree done: right subtree next
+        }
+        else
+        {
+            updateSize(node); // Both subtrees done
+            previous = node;
+            node = node->parent;
+        }
     }
+}
 
-    sf::Text text(std::to_string(node->value), font, 20);
-    text.setFillColor(sf::Color::White);
-    text.setPosition(x + 5, y + 5);
-    window.draw(text);
+RedBlackTree::Node *RedBlackTree::leftmost(Node *node)
+{
+    while (node != nullptr && node->left != nullptr)
+    {
+        node = node->left;
+    }
+    return node;
+}
 
-    if (node->left != nullptr)
+RedBlackTree::Node *RedBlackTree::rightmost(Node *node)
+{
+    while (node != nullptr && node->right != nullptr)
     {
-        visualizeEdges(window, node, x, y, offset);
-        visualizeNode(window, node->left, x - offset, y + 60, offset / 2);
+        node = node->right;
     }
+    return node;
+}
+
+RedBlackTree::Node *RedBlackTree::successor(Node *node)
+{
     if (node->right != nullptr)
+        return leftmost(node->right);
+
+    // Climb until coming up from a left child
+    while (node->parent != nullptr && node == node->parent->right)
     {
-        visualizeEdges(window, node, x, y, offset);
-        visualizeNode(window, node->right, x + offset, y + 60, offset / 2);
+        node = node->parent;
     }
+    return node->parent;
 }
 
-// Function to draw edges between parent and child nodes
-void RedBlackTree::visualizeEdges(sf::RenderWindow &window, Node *node, int x, int y, int offset)
+RedBlackTree::Node *RedBlackTree::predecessor(Node *node)
 {
     if (node->left != nullptr)
+        return rightmost(node->left);
+
+    // Climb until coming up from a right child
+    while (node->parent != nullptr && node == node->parent->left)
     {
-        sf::VertexArray line(sf::Lines, 2);
-        line[0].position = sf::Vector2f(x + 20, y + 20);
-        line[1].position = sf::Vector2f(x - offset + 20, y + 60 + 20);
-        line[0].color = sf::Color::White;
-        line[1].color = sf::Color::White;
-        window.draw(line);
+        node = node->parent;
     }
-    if (node->right != nullptr)
+    return node->parent;
+}
+
+void RedBlackTree::setOrderStatistics(bool enabled)
+{
+    if (enabled && !orderStatistics)
+    {
+        orderStatistics = true;
+        recomputeSizes();
+    }
+    orderStatistics = enabled;
+}
+
+const int *RedBlackTree::select(std::size_t k) const
+{
+    if (k >= size())
+        return nullptr;
+
+    if (!orderStatistics)
+    {
+        Node *node = leftmost(root);
+        for (; k > 0; --k)
+        {
+            node = successor(node);
+        }
+        return &node->value;
+    }
+
+    Node *node = root;
+    while (true)
+    {
+        std::size_t leftSize = sizeOf(node->left);
+        if (k < leftSize)
+        {
+            node = node->left;
+        }
+        else if (k == leftSize)
+        {
+            return &node->value;
+        }
+        else
+        {
+            k -= leftSize + 1; // Skip the left subtree and the node itself
+            node = node->right;
+        }
+    }
+}
+
+std::size_t RedBlackTree::countBelow(int value, bool inclusive) const
+{
+    std::size_t count = 0;
+    if (!orderStatistics)
+    {
+        for (Node *node = leftmost(root); node != nullptr && (node->value < value || (inclusive && node->value == value));
+             node = successor(node))
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    for (Node *node = root; node != nullptr;)
+    {
+        if (node->value < value || (inclusive && node->value == value))
+        {
+            count += sizeOf(node->left) + 1; // The node and everything left of it counts
+            node = node->right;
+        }
+        else
+        {
+            node = node->left;
+        }
+    }
+    return count;
+}
+
+std::size_t RedBlackTree::rank(int value) const
+{
+    return countBelow(value, false);
+}
+
+std::size_t RedBlackTree::count_range(int lo, int hi) const
+{
+    if (lo > hi)
+        return 0;
+    return countBelow(hi, true) - countBelow(lo, false);
+}
+
+// ------------------------------------------------------
+// Join-based bulk operations
+
+RedBlackTree::Node *RedBlackTree::attach(Node *node, Node *left, Node *right)
+{
+    node->left = left;
+    node->right = right;
+    if (left != nullptr)
+        left->parent = node;
+    if (right != nullptr)
+        right->parent = node;
+    node->size = 1 + sizeOf(left) + sizeOf(right);
+    return node;
+}
+
+RedBlackTree::Node *RedBlackTree::rotatedLeft(Node *node)
+{
+    Node *right = node->right;
+    attach(node, node->left, right->left);
+    return attach(right, node, right->right);
+}
+
+RedBlackTree::Node *RedBlackTree::rotatedRight(Node *node)
+{
+    Node *left = node->left;
+    attach(node, left->right, node->right);
+    return attach(left, left->left, node);
+}
+
+RedBlackTree::Subtree RedBlackTree::childOf(const Subtree &tree, Node *child)
+{
+    Subtree subtree = {child, tree.blackHeight - (isRed(tree.root) ? 0 : 1)};
+    if (child != nullptr)
+        child->parent = nullptr;
+    return subtree;
+}
+
+// Walk down the right spine of the taller left tree to a black node as tall as the
+// right tree, hang the middle node there in red, and repair a red-red pair with a
+// rotation on the way back up. The result is as tall as the left tree.
+RedBlackTree::Subtree RedBlackTree::joinRight(Subtree left, Node *middle, Subtree right)
+{
+    Node *path[maxHeight];
+    int depth = 0;
+    Node *node = left.root;
+    int blackHeight = left.blackHeight;
+    while (isRed(node) || blackHeight != right.blackHeight)
+    {
+        path[depth++] = node;
+        blackHeight -= isRed(node) ? 0 : 1;
+        node = node->right;
+    }
+
+    middle->color = Color::RED;
+    Node *joined = attach(middle, node, right.root);
+    while (depth > 0)
+    {
+        node = path[--depth];
+        attach(node, node->left, joined);
+        if (!isRed(node) && isRed(node->right) && isRed(node->right->right))
+        {
+            node->right->right->color = Color::BLACK;
+            node = rotatedLeft(node);
+        }
+        joined = node;
+    }
+    return Subtree{joined, left.blackHeight};
+}
+
+RedBlackTree::Subtree RedBlackTree::joinLeft(Subtree left, Node *middle, Subtree right)
+{
+    Node *path[maxHeight];
+    int depth = 0;
+    Node *node = right.root;
+    int blackHeight = right.blackHeight;
+    while (isRed(node) || blackHeight != left.blackHeight)
+    {
+        path[depth++] = node;
+        blackHeight -= isRed(node) ? 0 : 1;
+        node = node->left;
+    }
+
+    middle->color = Color::RED;
+    Node *joined = attach(middle, left.root, node);
+    while (depth > 0)
+    {
+        node = path[--depth];
+        attach(node, joined, node->right);
+        if (!isRed(node) && isRed(node->left) && isRed(node->left->left))
+        {
+            node->left->left->color = Color::BLACK;
+            node = rotatedRight(node);
+        }
+        joined = node;
+    }
+    return Subtree{joined, right.blackHeight};
+}
+
+// Join two trees and a middle node that sorts between them, in O(difference of their heights)
+RedBlackTree::Subtree RedBlackTree::join(Subtree left, Node *middle, Subtree right)
+{
+    Subtree joined;
+    if (left.blackHeight > right.blackHeight)
+    {
+        joined = joinRight(left, middle, right);
+        if (isRed(joined.root) && isRed(joined.root->right))
+        {
+            joined.root->color = Color::BLACK;
+            ++joined.blackHeight;
+        }
+    }
+    else if (right.blackHeight > left.blackHeight)
+    {
+        joined = joinLeft(left, middle, right);
+        if (isRed(joined.root) && isRed(joined.root->left))
+        {
+            joined.root->color = Color::BLACK;
+            ++joined.blackHeight;
+        }
+    }
+    else
+    {
+        middle->color = !isRed(left.root) && !isRed(right.root) ? Color::RED : Color::BLACK;
+        attach(middle, left.root, right.root);
+        joined = Subtree{middle, left.blackHeight + (isRed(middle) ? 0 : 1)};
+    }
+    joined.root->parent = nullptr;
+    return joined;
+}
+
+RedBlackTree::Subtree RedBlackTree::concat(Subtree left, Subtree right)
+{
+    if (left.root == nullptr)
+        return right;
+    if (right.root == nullptr)
+        return left;
+
+    Node *last;
+    Subtree rest = splitLast(left, last);
+    return join(rest, last, right);
+}
+
+// Walk down the right spine to the largest node, then join each left subtree on
+// the way back up with its root and what is left below it
+RedBlackTree::Subtree RedBlackTree::splitLast(Subtree tree, Node *&last)
+{
+    Subtree path[maxHeight];
+    int depth = 0;
+    while (tree.root->right != nullptr)
+    {
+        path[depth++] = tree;
+        tree = childOf(tree, tree.root->right);
+    }
+
+    last = tree.root;
+    Subtree rest = childOf(tree, last->left);
+    while (depth > 0)
+    {
+        Subtree above = path[--depth];
+        rest = join(childOf(above, above.root->left), above.root, rest);
+    }
+    return rest;
+}
+
+// less gets the values below key (or not above it, if inclusive) and rest the others.
+// Walk down to the key, keeping each node with the side of it the walk did not take,
+// then join those back onto less or rest on the way up.
+void RedBlackTree::split(Subtree tree, int key, bool inclusive, Subtree &less, Subtree &rest)
+{
+    Subtree path[maxHeight]; // The node as its subtree's root
+    Subtree aside[maxHeight]; // The side not walked into
+    int depth = 0;
+    while (tree.root != nullptr)
+    {
+        Node *node = tree.root;
+        path[depth] = tree;
+        if (node->value < key || (inclusive && node->value == key))
+        {
+            aside[depth++] = childOf(tree, node->left);
+            tree = childOf(tree, node->right);
+        }
+        else
+        {
+            aside[depth++] = childOf(tree, node->right);
+            tree = childOf(tree, node->left);
+        }
+    }
+
+    less = rest = Subtree{nullptr, 0};
+    while (depth > 0)
+    {
+        --depth;
+        Node *node = path[depth].root;
+        if (node->value < key || (inclusive && node->value == key))
+            less = join(aside[depth], node, less);
+        else
+            rest = join(rest, node, aside[depth]);
+    }
+}
+
+int RedBlackTree::parallelThreads()
+{
+    unsigned int threads = std::thread::hardware_concurrency();
+    return threads > 1 ? static_cast<int>(threads) : 1;
+}
+
+// The set operations divide around a pivot and put the two results back together
+// around it. A work list stands in for the recursion: a task either divides a pair
+// of subtrees, queueing the two halves, or combines the two results its halves left
+// on the results stack. While threads and values are plentiful, the left half is
+// handed to a thread of its own, which works through its own lists.
+//  - Unite splits b around a's root, and joins the halves back around that root.
+//  - Intersect and subtract split a three ways around b's root. The values equal to
+//    it stay between the halves for intersect, and go for subtract.
+RedBlackTree::Subtree RedBlackTree::combine(SetOperation operation, Subtree a, Subtree b, std::vector<Node *> &dropped, int threads)
+{
+    struct Forked
+    {
+        std::thread worker;
+        Subtree result;
+        std::vector<Node *> dropped; // Each thread collects its own
+    };
+    struct Task
+    {
+        Subtree a, b;
+        int threads;
+        bool dividing;                  // false: combine the results of the two halves
+        Node *middle;                   // Unite: the node joined back between the halves
+        Subtree equal;                  // Intersect: the values equal to the pivot
+        std::unique_ptr<Forked> forked; // The left half, when a thread works on it
+    };
+
+    std::vector<Task> tasks;
+    std::vector<Subtree> results;
+    tasks.push_back(Task{a, b, threads, true, nullptr, Subtree{nullptr, 0}, nullptr});
+    while (!tasks.empty())
+    {
+        Task task = std::move(tasks.back());
+        tasks.pop_back();
+        if (!task.dividing)
+        {
+            Subtree right = results.back();
+            results.pop_back();
+            Subtree left;
+            if (task.forked)
+            {
+                task.forked->worker.join();
+                left = task.forked->result;
+                dropped.insert(dropped.end(), task.forked->dropped.begin(), task.forked->dropped.end());
+            }
+            else
+            {
+                left = results.back();
+                results.pop_back();
+            }
+
+            if (operation == SetOperation::Unite)
+                results.push_back(join(left, task.middle, right));
+            else if (operation == SetOperation::Intersect)
+                results.push_back(concat(concat(left, task.equal), right));
+            else
+                results.push_back(concat(left, right));
+            continue;
+        }
+
+        Subtree leftA, leftB, rightA, rightB;
+        Task combining{Subtree{nullptr, 0}, Subtree{nullptr, 0}, task.threads, false, nullptr, Subtree{nullptr, 0}, nullptr};
+        int height;
+        if (operation == SetOperation::Unite)
+        {
+            if (task.a.root == nullptr || task.b.root == nullptr)
+            {
+                results.push_back(task.a.root == nullptr ? task.b : task.a);
+                continue;
+            }
+
+            combining.middle = task.a.root;
+            split(task.b, combining.middle->value, false, leftB, rightB);
+            leftA = childOf(task.a, combining.middle->left);
+            rightA = childOf(task.a, combining.middle->right);
+            height = task.a.blackHeight;
+        }
+        else
+        {
+            if (task.a.root == nullptr || task.b.root == nullptr)
+            {
+                collect(task.b.root, dropped);
+                if (operation == SetOperation::Intersect)
+                {
+                    collect(task.a.root, dropped);
+                    task.a = Subtree{nullptr, 0};
+                }
+                results.push_back(task.a);
+                continue;
+            }
+
+            Node *pivot = task.b.root;
+            Subtree aRest, aEqual;
+            split(task.a, pivot->value, false, leftA, aRest);
+            split(aRest, pivot->value, true, aEqual, rightA);
+            leftB = childOf(task.b, pivot->left);
+            rightB = childOf(task.b, pivot->right);
+            dropped.push_back(pivot);
+            if (operation == SetOperation::Intersect)
+                combining.equal = aEqual;
+            else
+                collect(aEqual.root, dropped);
+            height = task.b.blackHeight;
+        }
+
+        if (task.threads > 1 && height >= parallelBlackHeight)
+        {
+            Forked *forked = new Forked();
+            combining.forked.reset(forked);
+            int leftThreads = task.threads / 2;
+            forked->worker = std::thread([forked, operation, leftA, leftB, leftThreads]() {
+                forked->result = combine(operation, leftA, leftB, forked->dropped, leftThreads);
+            });
+            tasks.push_back(std::move(combining));
+            tasks.push_back(Task{rightA, rightB, task.threads - leftThreads, true, nullptr, Subtree{nullptr, 0}, nullptr});
+        }
+        else
+        {
+            tasks.push_back(std::move(combining));
+            tasks.push_back(Task{rightA, rightB, 1, true, nullptr, Subtree{nullptr, 0}, nullptr});
+            tasks.push_back(Task{leftA, leftB, 1, true, nullptr, Subtree{nullptr, 0}, nullptr});
+        }
+    }
+    return results.back();
+}
+
+void RedBlackTree::collect(Node *root, std::vector<Node *> &out)
+{
+    // Every node is visited from its parent, so the order is pre-order without a stack
+    std::size_t first = out.size();
+    if (root != nullptr)
+        out.push_back(root);
+    for (std::size_t i = first; i < out.size(); ++i)
+    {
+        if (out[i]->left != nullptr)
+            out.push_back(out[i]->left);
+        if (out[i]->right != nullptr)
+            out.push_back(out[i]->right);
+    }
+}
+
+RedBlackTree::Subtree RedBlackTree::takeTree(RedBlackTree &other)
+{
+    Subtree tree = {other.root, 0};
+    for (Node *node = other.root; node != nullptr; node = node->left)
+    {
+        tree.blackHeight += isRed(node) ? 0 : 1;
+    }
+
+    if (&other != this)
+    {
+        // Other's pool can join this one if no third tree holds nodes in it. Otherwise
+        // other keeps its pools too: its free list may hold slots in any of them.
+        borrowed.insert(borrowed.end(), other.borrowed.begin(), other.borrowed.end());
+        if (other.pool.use_count() == 1)
+        {
+            pool->splice(*other.pool);
+            other.borrowed.clear();
+        }
+        else
+        {
+            borrowed.push_back(other.pool);
+        }
+
+        std::sort(borrowed.begin(), borrowed.end());
+        borrowed.erase(std::unique(borrowed.begin(), borrowed.end()), borrowed.end());
+        borrowed.erase(std::remove(borrowed.begin(), borrowed.end(), pool), borrowed.end());
+
+        other.nodes.clear();
+        other.freeIds.clear();
+        other.layoutStale = false;
+        other.layout.clear();
+        other.scene.invalidate();
+    }
+    other.root = nullptr;
+    other.count = 0;
+    return tree;
+}
+
+void RedBlackTree::setTree(Subtree tree, const std::vector<Node *> &dropped)
+{
+    for (Node *node : dropped)
+    {
+        pool->release(node);
+    }
+
+    root = tree.root;
+    if (root != nullptr)
+    {
+        root->parent = nullptr;
+        root->color = Color::BLACK;
+    }
+    count = sizeOf(root);
+    orderStatistics = true; // attach kept every size on the way
+    layoutStale = true;
+    scene.invalidate();
+}
+
+void RedBlackTree::split(int key, RedBlackTree &right)
+{
+    if (&right == this)
+        return;
+
+    setOrderStatistics(true); // The halves' sizes come from the subtree sizes
+    right.clear();
+    Subtree less, rest;
+    split(takeTree(*this), key, false, less, rest);
+
+    // Right's nodes stay in this tree's pools, which right keeps alive from now on
+    right.borrowed = borrowed;
+    right.borrowed.push_back(pool);
+    right.setTree(rest, std::vector<Node *>());
+    setTree(less, std::vector<Node *>());
+}
+
+void RedBlackTree::join(RedBlackTree &left, int key, RedBlackTree &right)
+{
+    left.setOrderStatistics(true);
+    right.setOrderStatistics(true);
+    if (&left != this && &right != this)
+        clear();
+
+    Subtree leftTree = takeTree(left);
+    Subtree rightTree = takeTree(right);
+    Node *middle = pool->allocate(key, TreeLayout::None);
+    setTree(join(leftTree, middle, rightTree), std::vector<Node *>());
+}
+
+void RedBlackTree::unite(RedBlackTree &other)
+{
+    if (&other == this)
+        return;
+
+    setOrderStatistics(true);
+    other.setOrderStatistics(true);
+    Subtree a = takeTree(*this);
+    Subtree b = takeTree(other);
+    std::vector<Node *> dropped; // Stays empty: unite keeps every node
+    setTree(combine(SetOperation::Unite, a, b, dropped, parallelThreads()), dropped);
+}
+
+void RedBlackTree::intersect(RedBlackTree &other)
+{
+    if (&other == this)
+        return;
+
+    setOrderStatistics(true);
+    Subtree a = takeTree(*this);
+    Subtree b = takeTree(other);
+    std::vector<Node *> dropped;
+    Subtree result = combine(SetOperation::Intersect, a, b, dropped, parallelThreads());
+    setTree(result, dropped);
+}
+
+void RedBlackTree::subtract(RedBlackTree &other)
+{
+    if (&other == this)
+    {
+        clear();
+        return;
+    }
+
+    setOrderStatistics(true);
+    Subtree a = takeTree(*this);
+    Subtree b = takeTree(other);
+    std::vector<Node *> dropped;
+    Subtree result = combine(SetOperation::Subtract, a, b, dropped, parallelThreads());
+    setTree(result, dropped);
+}
+
+// In-order traversal, printing every value
+void RedBlackTree::inorderTraversal()
+{
+    for (int val : *this)
+    {
+        std::cout << val << " ";
+    }
+    std::cout << std::endl;
+}
+
+RedBlackTree::const_iterator RedBlackTree::begin() const
+{
+    return const_iterator(leftmost(root), this);
+}
+
+RedBlackTree::const_iterator RedBlackTree::end() const
+{
+    return const_iterator(nullptr, this);
+}
+
+IteratorRange<RedBlackTree::const_iterator> RedBlackTree::range(int lo, int hi) const
+{
+    if (lo > hi)
+        return IteratorRange<const_iterator>(end(), end());
+    return IteratorRange<const_iterator>(lower_bound(lo), upper_bound(hi));
+}
+
+// Function to visualize one node into the batch
+void RedBlackTree::visualizeNode(BatchRenderer &batch, Node *node, sf::Vector2f origin)
+{
+    sf::Vector2f center = origin + layout.getPosition(node->id);
+    batch.addCircle(center, 20, node->color == Color::RED ? sf::Color::Red : sf::Color::Black);
+    batch.addText(std::to_string(node->value), FontCache::get(), 20, center - sf::Vector2f(10, 12), sf::Color::White);
+
+    visualizeEdge(batch, node, origin);
+}
+
+// Function to add the edge between a node and its parent
+void RedBlackTree::visualizeEdge(BatchRenderer &batch, Node *node, sf::Vector2f origin)
+{
+    if (node->parent != nullptr)
     {
-        sf::VertexArray line(sf::Lines, 2);
-        line[0].position = sf::Vector2f(x + 20, y + 20);
-        line[1].position = sf::Vector2f(x + offset + 20, y + 60 + 20);
-        line[0].color = sf::Color::White;
-        line[1].color = sf::Color::White;
-        window.draw(line);
+        batch.addLine(origin + layout.getPosition(node->parent->id), origin + layout.getPosition(node->id), sf::Color::White);
     }
 }
 
-// Function to display the tree in a window
-void RedBlackTree::display(sf::RenderWindow &window)
+// Function to draw a whole subtree as one triangle, labelled with its size and height
+void RedBlackTree::visualizeSubtree(BatchRenderer &batch, Node *node, sf::Vector2f origin, float unitsPerPixel)
+{
+    sf::Vector2f top = origin + layout.getPosition(node->id);
+    sf::FloatRect bounds = layout.getSubtreeBounds(node->id);
+    float bottom = origin.y + bounds.top + bounds.height;
+    float left = std::min(origin.x + bounds.left, top.x - 20.f);
+    float right = std::max(origin.x + bounds.left + bounds.width, top.x + 20.f);
+
+    sf::Color color = node->color == Color::RED ? sf::Color::Red : sf::Color(90, 90, 90);
+    color.a = 160;
+    batch.addTriangle(top, sf::Vector2f(left, bottom), sf::Vector2f(right, bottom), color);
+    visualizeEdge(batch, node, origin);
+
+    // Labels keep a fixed on-screen size whatever the zoom
+    sf::Vector2f labelPosition(top.x - 8.f * unitsPerPixel, top.y + 4.f * unitsPerPixel);
+    batch.addText(std::to_string(layout.getSubtreeSize(node->id)), FontCache::get(), 12,
+                  labelPosition, sf::Color::White, unitsPerPixel);
+    batch.addText("h" + std::to_string(layout.getSubtreeHeight(node->id)), FontCache::get(), 12,
+                  labelPosition + sf::Vector2f(0.f, 14.f * unitsPerPixel), sf::Color::White, unitsPerPixel);
+}
+
+void RedBlackTree::setLevelOfDetail(bool enabled)
+{
+    levelOfDetail = enabled;
+    scene.invalidate();
+}
+
+// Function to display the tree on a render target
+void RedBlackTree::display(sf::RenderTarget &target)
 {
     if (root == nullptr)
         return;
-    visualizeNode(window, root, window.getSize().x / 2, 50, window.getSize().x / 4);
+    if (scene.needsRebuild(target))
+    {
+        if (layoutStale)
+            relinkLayout();
+        layout.update();
+        BatchRenderer &batch = scene.rebuild(target);
+        sf::Vector2f origin(target.getSize().x / 2.f, 70.f);
+
+        // Only the nodes whose circle or edge reaches the visible area
+        sf::FloatRect area = scene.getVisibleArea();
+        area.left -= origin.x;
+        area.top -= origin.y;
+        float unitsPerPixel = area.width / target.getSize().x;
+
+        visibleIds.clear();
+        collapsedIds.clear();
+        if (levelOfDetail)
+            layout.queryDetail(area, collapseWidth * unitsPerPixel, visibleIds, collapsedIds);
+        else
+            layout.query(area, visibleIds);
+
+        for (int id : visibleIds)
+        {
+            visualizeNode(batch, nodes[id], origin);
+        }
+        for (int id : collapsedIds)
+        {
+            visualizeSubtree(batch, nodes[id], origin, unitsPerPixel);
+        }
+    }
+    scene.draw(target); // Visible part of the tree in a constant number of draw calls
 }
 
 #endif // REDBLACKTREE_H
@@ -0,0 +1,63 @@
+#ifndef RETAINED_SCENE_H
+#define RETAINED_SCENE_H
+
+#include <SFML/Graphics.hpp>
+#include "BatchRenderer.h"
+#include "Camera.h"
+
+// Cached geometry for one structure. Mutations call invalidate(); visualize only
+// rebuilds the batch when the scene is stale and otherwise re-submits it as is.
+class RetainedScene
+{
+private:
+    BatchRenderer batch;
+    bool dirty;
+    sf::Vector2u targetSize;   // Some layouts depend on the target size, so a resize also invalidates
+    bool followsView;          // Culled scenes only hold what was visible, so panning or zooming invalidates
+    sf::FloatRect visibleArea; // World area the target's view showed at the last rebuild
+
+    static bool sameArea(const sf::FloatRect &a, const sf::FloatRect &b)
+    {
+        return a.left == b.left && a.top == b.top && a.width == b.width && a.height == b.height;
+    }
+
+public:
+    explicit RetainedScene(bool followsView = false)
+        : dirty(true), targetSize(0, 0), followsView(followsView) {}
+
+    // Mark the cached geometry as out of date
+    void invalidate()
+    {
+        dirty = true;
+    }
+
+    bool needsRebuild(const sf::RenderTarget &target) const
+    {
+        if (dirty || target.getSize() != targetSize)
+            return true;
+        return followsView && !sameArea(Camera::visibleArea(target.getView()), visibleArea);
+    }
+
+    // Start a rebuild for the given target and return the emptied batch to fill
+    BatchRenderer &rebuild(const sf::RenderTarget &target)
+    {
+        batch.clear();
+        dirty = false;
+        targetSize = target.getSize();
+        visibleArea = Camera::visibleArea(target.getView());
+        return batch;
+    }
+
+    // World area to fill during a rebuild; anything outside it is off screen
+    const sf::FloatRect &getVisibleArea() const
+    {
+        return visibleArea;
+    }
+
+    void draw(sf::RenderTarget &target) const
+    {
+        batch.draw(target);
+    }
+};
+
+#endif // RETAINED_SCENE_H
@@ -0,0 +1,121 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+// Bounded lock-free ring of ints for one producer and one consumer thread, used
+// to hand values from the ingest thread to the render loop.
+class SPSCQueue
+{
+private:
+    static const std::size_t cacheLine = 64;
+
+    std::vector<int> slots; // Read-only after construction, apart from the slot contents
+    std::size_t mask;
+
+    // Consumer side
+    alignas(cacheLine) std::atomic<std::size_t> head; // Next slot to read
+    std::size_t cachedTail;                           // Last tail the consumer saw
+
+    // Producer side
+    alignas(cacheLine) std::atomic<std::size_t> tail; // Next slot to write
+    std::size_t cachedHead;                           // Last head the producer saw
+
+public:
+    explicit SPSCQueue(std::size_t capacity); // Rounded up to a power of two
+
+    SPSCQueue(const SPSCQueue &) = delete;
+    SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+    // Producer thread only
+    bool try_enqueue(int value);                                 // False if the ring is full
+    std::size_t try_enqueue_range(const int *values, std::size_t n); // How many of the values fit
+
+    // Consumer thread only
+    bool try_dequeue(int &value);                     // False if the ring is empty
+    std::size_t try_dequeue_n(int *out, std::size_t n); // Up to n values, returns how many
+
+    std::size_t size_approx() const; // Exact when called from either side with the other one idle
+    std::size_t capacity() const;
+};
+
+// ------------------------------------------------------
+// Implementation of SPSCQueue methods
+
+SPSCQueue::SPSCQueue(std::size_t capacity) : head(0), cachedTail(0), tail(0), cachedHead(0)
+{
+    std::size_t size = 1;
+    while (size < capacity)
+    {
+        size *= 2;
+    }
+    slots.resize(size);
+    mask = size - 1;
+}
+
+bool SPSCQueue::try_enqueue(int value)
+{
+    return try_enqueue_range(&value, 1) == 1;
+}
+
+std::size_t SPSCQueue::try_enqueue_range(const int *values, std::size_t n)
+{
+    std::size_t position = tail.load(std::memory_order_relaxed); // Only this thread writes tail
+    std::size_t space = slots.size() - (position - cachedHead);
+    if (space < n)
+    {
+        cachedHead = head.load(std::memory_order_acquire); // The consumer may have made room since
+        space = slots.size() - (position - cachedHead);
+    }
+
+    n = std::min(n, space);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        slots[(position + i) & mask] = values[i];
+    }
+    if (n > 0)
+        tail.store(position + n, std::memory_order_release); // Publish the whole batch at once
+    return n;
+}
+
+bool SPSCQueue::try_dequeue(int &value)
+{
+    return try_dequeue_n(&value, 1) == 1;
+}
+
+std::size_t SPSCQueue::try_dequeue_n(int *out, std::size_t n)
+{
+    std::size_t position = head.load(std::memory_order_relaxed); // Only this thread writes head
+    std::size_t available = cachedTail - position;
+    if (available < n)
+    {
+        cachedTail = tail.load(std::memory_order_acquire); // The producer may have published more
+        available = cachedTail - position;
+    }
+
+    n = std::min(n, available);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        out[i] = slots[(position + i) & mask];
+    }
+    if (n > 0)
+        head.store(position + n, std::memory_order_release); // Hand the slots back to the producer
+    return n;
+}
+
+std::size_t SPSCQueue::size_approx() const
+{
+    std::size_t first = head.load(std::memory_order_acquire);
+    std::size_t last = tail.load(std::memory_order_acquire);
+    return last >= first ? last - first : 0;
+}
+
+std::size_t SPSCQueue::capacity() const
+{
+    return slots.size();
+}
+
+#endif // SPSC_QUEUE_H
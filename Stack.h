@@ -3,62 +3,112 @@
 
 #include <SFML/Graphics.hpp>
 #include <vector>
+#include <memory>
+#include <algorithm>
 #include <iostream>
+#include "FontCache.h"
+#include "RetainedScene.h"
+#include "ConcurrentStack.h"
 
 class Stack
 {
+public:
+    // Storage behind the stack, chosen at construction
+    enum class Backend
+    {
+        Vector,    // Plain vector, for the render thread only
+        Concurrent // Lock-free ConcurrentStack: push, pop and isEmpty may be called from any thread
+    };
+
 private:
-    std::vector<int> stack; // Using vector to represent the stack
+    Backend backend;
+    std::vector<int> stack;                  // Using vector to represent the stack
+    std::unique_ptr<ConcurrentStack> shared; // Used instead of stack by the concurrent backend
+    std::vector<int> snapshot;               // Concurrent stack as last drawn, bottom first
+    std::vector<int> latest;                 // Scratch copy the next snapshot is taken into
+    RetainedScene scene;                     // Cached geometry, rebuilt only after push/pop
 
 public:
+    explicit Stack(Backend backend = Backend::Vector)
+        : backend(backend), shared(backend == Backend::Concurrent ? new ConcurrentStack() : nullptr)
+    {
+    }
+
+    Backend getBackend() const
+    {
+        return backend;
+    }
+
     // Pushes an element onto the stack
     void push(int value)
     {
+        if (shared)
+        {
+            shared->push(value); // visualize notices the change through its snapshot
+            return;
+        }
         stack.push_back(value);
+        scene.invalidate();
     }
 
-    // Pops an element from the stack
-    void pop()
+    // Pops an element from the stack; false if it was empty
+    bool pop()
     {
-        if (!stack.empty())
+        if (shared)
         {
-            stack.pop_back();
+            int value;
+            return shared->pop(value);
         }
+        if (stack.empty())
+            return false;
+        stack.pop_back();
+        scene.invalidate();
+        return true;
     }
 
-    // Visualizes the stack in the window
-    void visualize(sf::RenderWindow &window)
+    // Visualizes the stack on a render target (window or texture)
+    void visualize(sf::RenderTarget &target)
     {
-        for (int i = 0; i < stack.size(); i++)
+        if (shared)
         {
-            sf::RectangleShape rect(sf::Vector2f(50, 50));
-            rect.setPosition(100.0f, 100.0f + i * 60);
-            rect.setFillColor(sf::Color::Red);
-            window.draw(rect);
+            // Workers keep pushing and popping; draw the stack as of one instant, and
+            // only rebuild the geometry when that differs from what is on screen
+            shared->snapshot(latest);
+            std::reverse(latest.begin(), latest.end());
+            if (latest != snapshot)
+            {
+                snapshot.swap(latest);
+                scene.invalidate();
+            }
+        }
 
-            // Display the number inside the rectangle
-            sf::Font font;
-            if (!font.loadFromFile("Arial.ttf"))
+        if (scene.needsRebuild(target))
+        {
+            const std::vector<int> &values = shared ? snapshot : stack;
+            BatchRenderer &batch = scene.rebuild(target);
+            for (int i = 0; i < values.size(); i++)
             {
-                std::cerr << "Error loading font!" << std::endl;
+                batch.addRectangle(sf::Vector2f(100.0f, 100.0f + i * 60), sf::Vector2f(50, 50), sf::Color::Red);
+
+                // Display the number inside the rectangle
+                batch.addText(std::to_string(values[i]), FontCache::get(), 20,
+                              sf::Vector2f(115.0f, 110.0f + i * 60), sf::Color::White);
             }
-            sf::Text text(std::to_string(stack[i]), font, 20);
-            text.setPosition(115.0f, 110.0f + i * 60);
-            text.setFillColor(sf::Color::White);
-            window.draw(text);
         }
+        scene.draw(target);
     }
 
     // Checks if the stack is empty
     bool isEmpty() const
     {
-        return stack.empty();
+        return shared ? shared->empty() : stack.empty();
     }
 
-    // Returns the top element of the stack
+    // Returns the top element of the stack; with the concurrent backend, as drawn last
     int top() const
     {
-        return stack.empty() ? -1 : stack.back();
+        const std::vector<int> &values = shared ? snapshot : stack;
+        return values.empty() ? -1 : values.back();
     }
 };
 
@@ -0,0 +1,512 @@
+#ifndef TREE_LAYOUT_H
+#define TREE_LAYOUT_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <utility>
+#include <tuple>
+#include <algorithm>
+
+// Reingold-Tilford tidy layout for binary trees keyed by node id. Only changed
+// subtrees are recomputed, and positions are placed lazily by the queries.
+class TreeLayout
+{
+public:
+    static const int None = -1;
+
+private:
+    // Tree shape, as reported by the owning structure
+    std::vector<int> leftChild;
+    std::vector<int> rightChild;
+    std::vector<int> parent;
+    int root;
+
+    // Relative layout of each subtree, valid while the node is clean
+    std::vector<float> childOffset;       // Horizontal distance from a node to each of its children
+    std::vector<int> height;              // Number of levels below the node
+    std::vector<int> leftThread;          // Next left contour node for a node without children
+    std::vector<int> rightThread;         // Next right contour node for a node without children
+    std::vector<float> leftThreadOffset;  // Horizontal distance from a node to its left thread
+    std::vector<float> rightThreadOffset; // Horizontal distance from a node to its right thread
+    std::vector<int> lowestLeft;          // Leftmost node on the subtree's lowest level
+    std::vector<int> lowestRight;         // Rightmost node on the subtree's lowest level
+    std::vector<float> lowestLeftX;       // ... and their x relative to the subtree root
+    std::vector<float> lowestRightX;
+    std::vector<float> extentLeft;  // Leftmost x in the subtree, relative to its root
+    std::vector<float> extentRight; // Rightmost x in the subtree, relative to its root
+    std::vector<int> subtreeSize;   // Number of nodes in the subtree
+    std::vector<char> dirty;
+
+    std::vector<int> touched; // Nodes whose children changed since the last update
+    int arrayCount;           // Node count when used for an implicit array tree
+
+    // Absolute positions, root at x = 0 and y = 0, of the nodes the last query walked
+    std::vector<sf::Vector2f> positions;
+    sf::FloatRect bounds;
+
+    float nodeSeparation;  // Minimum horizontal distance between neighbours on a level
+    float levelSeparation; // Vertical distance between levels
+
+    void grow(int id);
+    void markDirty(int id);
+    void layoutSubtree(int id);
+    void placeChildren(int id); // Position a placed node's children from its child offset
+    sf::FloatRect nodeBox(int id) const;
+    sf::FloatRect subtreeBox(int id) const;
+    std::pair<int, float> nextLeft(int id, float x) const;
+    std::pair<int, float> nextRight(int id, float x) const;
+
+public:
+    TreeLayout(float nodeSeparation, float levelSeparation);
+
+    void setRoot(int id);                         // Set the root, or None for an empty tree
+    void setChildren(int id, int left, int right); // Record the children of a node
+    void setArrayTree(int count);                  // Use the implicit tree of a binary heap with count nodes
+    void clear();
+
+    // Record the current children of a pointer-based node with id/left/right members
+    template <typename NodeT>
+    void updateLinks(const NodeT *node)
+    {
+        setChildren(node->id, node->left ? node->left->id : None, node->right ? node->right->id : None);
+    }
+
+    void update(); // Recompute stale subtrees
+
+    sf::Vector2f getPosition(int id) const; // Position of a node the last query walked, relative to the root
+    sf::FloatRect getBounds() const;        // Box around all node positions
+    int getRoot() const;
+    int getParent(int id) const;
+
+    int getSubtreeSize(int id) const;
+    int getSubtreeHeight(int id) const;       // Levels below the node
+    float getSubtreeWidth(int id) const;      // Distance between the outermost nodes of the subtree
+    sf::FloatRect getSubtreeBounds(int id) const; // Box around the subtree's node positions
+
+    // Append the nodes whose circle or edge to their parent overlaps the area,
+    // given in the same coordinates as getPosition. Walks down from the root and
+    // skips subtrees whose box misses the area.
+    void query(const sf::FloatRect &area, std::vector<int> &result);
+
+    // Level-of-detail variant of query: walks down from the root, skipping subtrees
+    // outside the area and stopping at subtrees narrower than minWidth, which go to
+    // collapsed instead of having their nodes listed in detailed
+    void queryDetail(const sf::FloatRect &area, float minWidth,
+                     std::vector<int> &detailed, std::vector<int> &collapsed);
+};
+
+// ------------------------------------------------------
+// Implementation of TreeLayout methods
+
+const int TreeLayout::None;
+
+TreeLayout::TreeLayout(float nodeSeparation, float levelSeparation)
+    : root(None), arrayCount(0), nodeSeparation(nodeSeparation), levelSeparation(levelSeparation)
+{
+}
+
+// Make room for per-node data up to and including id
+void TreeLayout::grow(int id)
+{
+    if (id < static_cast<int>(leftChild.size()))
+        return;
+
+    int size = std::max(id + 1, static_cast<int>(leftChild.size()) * 2);
+    leftChild.resize(size, None);
+    rightChild.resize(size, None);
+    parent.resize(size, None);
+    childOffset.resize(size, 0.f);
+    height.resize(size, 0);
+    leftThread.resize(size, None);
+    rightThread.resize(size, None);
+    leftThreadOffset.resize(size, 0.f);
+    rightThreadOffset.resize(size, 0.f);
+    lowestLeft.resize(size, None);
+    lowestRight.resize(size, None);
+    lowestLeftX.resize(size, 0.f);
+    lowestRightX.resize(size, 0.f);
+    extentLeft.resize(size, 0.f);
+    extentRight.resize(size, 0.f);
+    subtreeSize.resize(size, 1);
+    dirty.resize(size, 0);
+    positions.resize(size);
+}
+
+void TreeLayout::markDirty(int id)
+{
+    if (!dirty[id])
+    {
+        dirty[id] = 1;
+        touched.push_back(id);
+    }
+}
+
+void TreeLayout::setRoot(int id)
+{
+    root = id;
+    if (id != None)
+    {
+        grow(id);
+        parent[id] = None;
+        markDirty(id);
+    }
+}
+
+void TreeLayout::setChildren(int id, int left, int right)
+{
+    grow(std::max(id, std::max(left, right)));
+    leftChild[id] = left;
+    rightChild[id] = right;
+    if (left != None)
+        parent[left] = id;
+    if (right != None)
+        parent[right] = id;
+    markDirty(id);
+}
+
+// Node i of a binary heap has children 2i + 1 and 2i + 2; only the nodes at the
+// changed end of the array and their parents need to be relinked
+void TreeLayout::setArrayTree(int count)
+{
+    grow(std::max(count, 1) - 1);
+
+    int first = std::min(arrayCount, count);
+    int last = std::max(arrayCount, count);
+    arrayCount = count;
+
+    for (int i = first; i < last; ++i)
+    {
+        if (i < count)
+            setChildren(i, None, None);
+
+        if (i > 0)
+        {
+            int p = (i - 1) / 2;
+            if (p < count)
+                setChildren(p, 2 * p + 1 < count ? 2 * p + 1 : None, 2 * p + 2 < count ? 2 * p + 2 : None);
+        }
+    }
+    setRoot(count > 0 ? 0 : None);
+}
+
+void TreeLayout::clear()
+{
+    std::fill(leftChild.begin(), leftChild.end(), None);
+    std::fill(rightChild.begin(), rightChild.end(), None);
+    std::fill(parent.begin(), parent.end(), None);
+    std::fill(dirty.begin(), dirty.end(), 0);
+    touched.clear();
+    root = None;
+    arrayCount = 0;
+}
+
+// Step from a left contour node to the left contour node one level down
+std::pair<int, float> TreeLayout::nextLeft(int id, float x) const
+{
+    if (leftChild[id] != None)
+        return std::make_pair(leftChild[id], x - childOffset[id]);
+    if (rightChild[id] != None)
+        return std::make_pair(rightChild[id], x + childOffset[id]);
+    return std::make_pair(leftThread[id], x + leftThreadOffset[id]);
+}
+
+// Step from a right contour node to the right contour node one level down
+std::pair<int, float> TreeLayout::nextRight(int id, float x) const
+{
+    if (rightChild[id] != None)
+        return std::make_pair(rightChild[id], x + childOffset[id]);
+    if (leftChild[id] != None)
+        return std::make_pair(leftChild[id], x - childOffset[id]);
+    return std::make_pair(rightThread[id], x + rightThreadOffset[id]);
+}
+
+// Merge the layouts of a node's two subtrees, whose own layouts are already valid.
+// Only the levels both subtrees share are walked, which keeps the total work linear.
+void TreeLayout::layoutSubtree(int id)
+{
+    int left = leftChild[id];
+    int right = rightChild[id];
+
+    if (left == None && right == None)
+    {
+        childOffset[id] = 0.f;
+        height[id] = 0;
+        lowestLeft[id] = lowestRight[id] = id;
+        lowestLeftX[id] = lowestRightX[id] = 0.f;
+        extentLeft[id] = extentRight[id] = 0.f;
+        subtreeSize[id] = 1;
+        return;
+    }
+
+    if (left == None || right == None)
+    {
+        // A single child sits half a separation to its side
+        int child = left != None ? left : right;
+        float dx = left != None ? -nodeSeparation / 2.f : nodeSeparation / 2.f;
+        childOffset[id] = nodeSeparation / 2.f;
+        height[id] = height[child] + 1;
+        lowestLeft[id] = lowestLeft[child];
+        lowestRight[id] = lowestRight[child];
+        lowestLeftX[id] = lowestLeftX[child] + dx;
+        lowestRightX[id] = lowestRightX[child] + dx;
+        extentLeft[id] = std::min(0.f, extentLeft[child] + dx);
+        extentRight[id] = std::max(0.f, extentRight[child] + dx);
+        subtreeSize[id] = subtreeSize[child] + 1;
+        return;
+    }
+
+    // Walk the right contour of the left subtree against the left contour of the right one,
+    // tracking positions relative to each subtree root and the root distance needed so far
+    int leftHeight = height[left];
+    int rightHeight = height[right];
+    int sharedLevels = std::min(leftHeight, rightHeight);
+
+    int l = left, r = right;
+    float lx = 0.f, rx = 0.f;
+    float distance = nodeSeparation;
+
+    for (int level = 0;; ++level)
+    {
+        distance = std::max(distance, lx - rx + nodeSeparation);
+        if (level == sharedLevels)
+            break;
+        std::tie(l, lx) = nextRight(l, lx);
+        std::tie(r, rx) = nextLeft(r, rx);
+    }
+
+    float half = distance / 2.f;
+    childOffset[id] = half;
+    height[id] = std::max(leftHeight, rightHeight) + 1;
+    subtreeSize[id] = subtreeSize[left] + subtreeSize[right] + 1;
+
+    // A deep right subtree can reach further left than a shallow left one, and vice versa
+    extentLeft[id] = std::min(extentLeft[left] - half, extentLeft[right] + half);
+    extentRight[id] = std::max(extentRight[left] - half, extentRight[right] + half);
+
+    if (leftHeight == rightHeight)
+    {
+        lowestLeft[id] = lowestLeft[left];
+        lowestLeftX[id] = lowestLeftX[left] - half;
+        lowestRight[id] = lowestRight[right];
+        lowestRightX[id] = lowestRightX[right] + half;
+    }
+    else if (leftHeight < rightHeight)
+    {
+        // The left contour continues below the left subtree into the right one
+        std::pair<int, float> target = nextLeft(r, rx);
+        int source = lowestLeft[left];
+        leftThread[source] = target.first;
+        leftThreadOffset[source] = (target.second + half) - (lowestLeftX[left] - half);
+
+        lowestLeft[id] = lowestLeft[right];
+        lowestLeftX[id] = lowestLeftX[right] + half;
+        lowestRight[id] = lowestRight[right];
+        lowestRightX[id] = lowestRightX[right] + half;
+    }
+    else
+    {
+        // The right contour continues below the right subtree into the left one
+        std::pair<int, float> target = nextRight(l, lx);
+        int source = lowestRight[right];
+        rightThread[source] = target.first;
+        rightThreadOffset[source] = (target.second - half) - (lowestRightX[right] + half);
+
+        lowestLeft[id] = lowestLeft[left];
+        lowestLeftX[id] = lowestLeftX[left] - half;
+        lowestRight[id] = lowestRight[left];
+        lowestRightX[id] = lowestRightX[left] - half;
+    }
+}
+
+void TreeLayout::placeChildren(int id)
+{
+    sf::Vector2f position = positions[id];
+    if (leftChild[id] != None)
+        positions[leftChild[id]] = sf::Vector2f(position.x - childOffset[id], position.y + levelSeparation);
+    if (rightChild[id] != None)
+        positions[rightChild[id]] = sf::Vector2f(position.x + childOffset[id], position.y + levelSeparation);
+}
+
+void TreeLayout::update()
+{
+    if (touched.empty())
+        return;
+
+    // Every ancestor of a changed node needs its contours merged again
+    for (std::size_t i = 0; i < touched.size(); ++i)
+    {
+        for (int id = parent[touched[i]]; id != None && !dirty[id]; id = parent[id])
+        {
+            dirty[id] = 1;
+        }
+    }
+    touched.clear();
+
+    // Post-order over the dirty nodes only; clean subtrees keep their relative layout
+    if (root != None && dirty[root])
+    {
+        std::vector<std::pair<int, bool>> pending;
+        pending.push_back(std::make_pair(root, false));
+
+        while (!pending.empty())
+        {
+            std::pair<int, bool> &top = pending.back();
+            int id = top.first;
+
+            if (!top.second)
+            {
+                top.second = true;
+                if (leftChild[id] != None && dirty[leftChild[id]])
+                    pending.push_back(std::make_pair(leftChild[id], false));
+                if (rightChild[id] != None && dirty[rightChild[id]])
+                    pending.push_back(std::make_pair(rightChild[id], false));
+            }
+            else
+            {
+                pending.pop_back();
+                layoutSubtree(id);
+                dirty[id] = 0;
+            }
+        }
+    }
+
+    bounds = root == None ? sf::FloatRect(0.f, 0.f, 0.f, 0.f)
+                          : sf::FloatRect(extentLeft[root], 0.f, extentRight[root] - extentLeft[root], height[root] * levelSeparation);
+}
+
+sf::Vector2f TreeLayout::getPosition(int id) const
+{
+    return positions[id];
+}
+
+sf::FloatRect TreeLayout::getBounds() const
+{
+    return bounds;
+}
+
+int TreeLayout::getRoot() const
+{
+    return root;
+}
+
+int TreeLayout::getParent(int id) const
+{
+    return id == root ? None : parent[id];
+}
+
+int TreeLayout::getSubtreeSize(int id) const
+{
+    return subtreeSize[id];
+}
+
+int TreeLayout::getSubtreeHeight(int id) const
+{
+    return height[id];
+}
+
+float TreeLayout::getSubtreeWidth(int id) const
+{
+    return extentRight[id] - extentLeft[id];
+}
+
+sf::FloatRect TreeLayout::getSubtreeBounds(int id) const
+{
+    sf::Vector2f position = positions[id];
+    return sf::FloatRect(position.x + extentLeft[id], position.y,
+                         extentRight[id] - extentLeft[id], height[id] * levelSeparation);
+}
+
+// Box around a node's circle and the edge up to its parent
+sf::FloatRect TreeLayout::nodeBox(int id) const
+{
+    float radius = nodeSeparation / 2.f; // Nodes are never wider than the separation between them
+    sf::Vector2f position = positions[id];
+    float left = position.x - radius, right = position.x + radius;
+    float top = position.y - radius, bottom = position.y + radius;
+
+    if (id != root)
+    {
+        sf::Vector2f above = positions[parent[id]];
+        left = std::min(left, above.x);
+        right = std::max(right, above.x);
+        top = std::min(top, above.y);
+    }
+    return sf::FloatRect(left, top, right - left, bottom - top);
+}
+
+// Box around a subtree's circles and the edge up to its parent
+sf::FloatRect TreeLayout::subtreeBox(int id) const
+{
+    float radius = nodeSeparation / 2.f;
+    sf::FloatRect box = getSubtreeBounds(id);
+    float left = box.left - radius, right = box.left + box.width + radius;
+    float top = box.top - radius, bottom = box.top + box.height + radius;
+
+    if (id != root)
+    {
+        sf::Vector2f above = positions[parent[id]];
+        left = std::min(left, above.x);
+        right = std::max(right, above.x);
+        top = std::min(top, above.y);
+    }
+    return sf::FloatRect(left, top, right - left, bottom - top);
+}
+
+void TreeLayout::query(const sf::FloatRect &area, std::vector<int> &result)
+{
+    if (root == None)
+        return;
+
+    positions[root] = sf::Vector2f(0.f, 0.f);
+    std::vector<int> pending(1, root);
+    while (!pending.empty())
+    {
+        int id = pending.back();
+        pending.pop_back();
+
+        if (!subtreeBox(id).intersects(area))
+            continue;
+        if (nodeBox(id).intersects(area))
+            result.push_back(id);
+
+        placeChildren(id);
+        if (leftChild[id] != None)
+            pending.push_back(leftChild[id]);
+        if (rightChild[id] != None)
+            pending.push_back(rightChild[id]);
+    }
+}
+
+void TreeLayout::queryDetail(const sf::FloatRect &area, float minWidth,
+                             std::vector<int> &detailed, std::vector<int> &collapsed)
+{
+    if (root == None)
+        return;
+
+    positions[root] = sf::Vector2f(0.f, 0.f);
+    std::vector<int> pending(1, root);
+    while (!pending.empty())
+    {
+        int id = pending.back();
+        pending.pop_back();
+
+        if (!subtreeBox(id).intersects(area))
+            continue;
+
+        bool isLeaf = leftChild[id] == None && rightChild[id] == None;
+        if (!isLeaf && extentRight[id] - extentLeft[id] < minWidth)
+        {
+            collapsed.push_back(id);
+            continue;
+        }
+
+        detailed.push_back(id);
+        placeChildren(id);
+        if (leftChild[id] != None)
+            pending.push_back(leftChild[id]);
+        if (rightChild[id] != None)
+            pending.push_back(rightChild[id]);
+    }
+}
+
+#endif // TREE_LAYOUT_H
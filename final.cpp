@@ -2,6 +2,14 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <memory>
 #include "LinkedList.h"
 #include "BST.h"
 #include "Heap.h"          // Combined Heap class
@@ -9,6 +17,12 @@
 #include "Stack.h"         // Include Stack header
 #include "Queue.h"         // Include Queue header
 #include "PriorityQueue.h" // Include PriorityQueue header
+#include "FontCache.h"     // Shared font for every structure and the menu
+#include "RetainedScene.h" // Cached menu geometry
+#include "Camera.h"        // Pan and zoom over the structures
+#include "FrameScheduler.h" // Frame pacing and idle waiting
+#include "Benchmark.h"      // Throughput of the structure cores
+#include "SPSCQueue.h"      // Values handed over from the ingest thread
 
 using namespace std;
 
@@ -29,9 +43,11 @@ class Menu
 {
 private:
     vector<sf::Text> menuItems;
-    sf::Font font;
+    vector<string> menuLabels;
+    RetainedScene menuScene; // Rebuilt only when the selection moves
     int selectedItemIndex;
     AppState currentState;
+    bool levelOfDetail; // Collapse narrow subtrees in the trees, toggled with L
 
     LinkedList linkedList; // Instance of the LinkedList class
     BST bst;               // Instance of the BinarySearchTree class
@@ -42,39 +58,38 @@ private:
     PriorityQueue pq;      // Instance of the PriorityQueue class
 
 public:
-    Menu();
+    explicit Menu(Stack::Backend stackBackend = Stack::Backend::Vector);
     void handleInput(sf::Event::KeyEvent key);
     void updateMenu();
-    void draw(sf::RenderWindow &window);
-    void displayLinkedList(sf::RenderWindow &window);
-    void displayBST(sf::RenderWindow &window);
-    void displayHeap(sf::RenderWindow &window);
-    void displayRedBlackTree(sf::RenderWindow &window);
-    void displayStack(sf::RenderWindow &window);         // Added Stack display function
-    void displayQueue(sf::RenderWindow &window);         // Added Queue display function
-    void displayPriorityQueue(sf::RenderWindow &window); // Added PriorityQueue display function
+    void draw(sf::RenderTarget &target);
+    void displayLinkedList(sf::RenderTarget &target);
+    void displayBST(sf::RenderTarget &target);
+    void displayHeap(sf::RenderTarget &target);
+    void displayRedBlackTree(sf::RenderTarget &target);
+    void displayStack(sf::RenderTarget &target);         // Added Stack display function
+    void displayQueue(sf::RenderTarget &target);         // Added Queue display function
+    void displayPriorityQueue(sf::RenderTarget &target); // Added PriorityQueue display function
+    void display(AppState state, sf::RenderTarget &target); // Draw the screen of a given state
     void addNode(int value);
     AppState getCurrentState() const;
+    Stack &getStack(); // For the worker threads of a concurrent stack
     void initializeDataStructures();
 };
 
-Menu::Menu() : selectedItemIndex(0), currentState(AppState::MainMenu)
+Menu::Menu(Stack::Backend stackBackend)
+    : selectedItemIndex(0), currentState(AppState::MainMenu), levelOfDetail(true), stack(stackBackend)
 {
-    if (!font.loadFromFile("Arial.ttf"))
-    {
-        std::cerr << "Error loading font!" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-
     vector<string> menuTexts = {
         "Linked List", "Binary Search Tree", "Heap", "Red-Black Tree", "Stack", "Queue", "Priority Queue", "Exit"};
 
     for (int i = 0; i < menuTexts.size(); ++i)
     {
-        sf::Text item(menuTexts[i], font, 30);
+        sf::Text item(menuTexts[i], FontCache::get(), 30);
         item.setPosition(100, 100 + i * 50);
         menuItems.push_back(item);
     }
+    menuLabels = menuTexts;
+    updateMenu();
 
     // Initialize all data structures with predefined nodes
     initializeDataStructures();
@@ -85,12 +100,24 @@ void Menu::handleInput(sf::Event::KeyEvent key)
     if (key.code == sf::Keyboard::Up)
     {
         if (selectedItemIndex > 0)
+        {
             selectedItemIndex--;
+            updateMenu();
+        }
     }
     else if (key.code == sf::Keyboard::Down)
     {
         if (selectedItemIndex < menuItems.size() - 1)
+        {
             selectedItemIndex++;
+            updateMenu();
+        }
+    }
+    else if (key.code == sf::Keyboard::L)
+    {
+        levelOfDetail = !levelOfDetail;
+        bst.setLevelOfDetail(levelOfDetail);
+        rbTree.setLevelOfDetail(levelOfDetail);
     }
     else if (key.code == sf::Keyboard::Return)
     {
@@ -137,49 +164,88 @@ void Menu::updateMenu()
             menuItems[i].setFillColor(sf::Color::White);
         }
     }
+    menuScene.invalidate();
 }
 
-void Menu::draw(sf::RenderWindow &window)
+void Menu::draw(sf::RenderTarget &target)
 {
-    for (auto &item : menuItems)
+    if (menuScene.needsRebuild(target))
     {
-        window.draw(item);
+        BatchRenderer &batch = menuScene.rebuild(target);
+        for (int i = 0; i < menuItems.size(); ++i)
+        {
+            batch.addText(menuLabels[i], FontCache::get(), 30, menuItems[i].getPosition(), menuItems[i].getFillColor());
+        }
     }
+    menuScene.draw(target);
 }
 
-void Menu::displayLinkedList(sf::RenderWindow &window)
+void Menu::displayLinkedList(sf::RenderTarget &target)
 {
-    linkedList.visualize(window);
+    linkedList.visualize(target);
 }
 
-void Menu::displayBST(sf::RenderWindow &window)
+void Menu::displayBST(sf::RenderTarget &target)
 {
-    bst.visualize(window);
+    bst.visualize(target);
 }
 
-void Menu::displayHeap(sf::RenderWindow &window)
+void Menu::displayHeap(sf::RenderTarget &target)
 {
-    heap.visualize(window);
+    heap.visualize(target);
 }
 
-void Menu::displayRedBlackTree(sf::RenderWindow &window)
+void Menu::displayRedBlackTree(sf::RenderTarget &target)
 {
-    rbTree.display(window);
+    rbTree.display(target);
 }
 
-void Menu::displayStack(sf::RenderWindow &window)
+void Menu::displayStack(sf::RenderTarget &target)
 {
-    stack.visualize(window); // Display the stack visualization
+    stack.visualize(target); // Display the stack visualization
 }
 
-void Menu::displayQueue(sf::RenderWindow &window)
+void Menu::displayQueue(sf::RenderTarget &target)
 {
-    queue.visualize(window); // Display the queue visualization
+    queue.visualize(target); // Display the queue visualization
 }
 
-void Menu::displayPriorityQueue(sf::RenderWindow &window)
+void Menu::displayPriorityQueue(sf::RenderTarget &target)
 {
-    pq.visualize(window); // Display the priority queue visualization
+    pq.visualize(target); // Display the priority queue visualization
+}
+
+void Menu::display(AppState state, sf::RenderTarget &target)
+{
+    switch (state)
+    {
+    case AppState::MainMenu:
+        draw(target);
+        break;
+    case AppState::LinkedList:
+        displayLinkedList(target);
+        break;
+    case AppState::BinarySearchTree:
+        displayBST(target);
+        break;
+    case AppState::Heap:
+        displayHeap(target);
+        break;
+    case AppState::RedBlackTree:
+        displayRedBlackTree(target);
+        break;
+    case AppState::Stack:
+        displayStack(target); // Display Stack
+        break;
+    case AppState::Queue:
+        displayQueue(target); // Display Queue
+        break;
+    case AppState::PriorityQueue:
+        displayPriorityQueue(target); // Display PriorityQueue
+        break;
+    case AppState::Exit:
+        break;
+    }
 }
 
 void Menu::addNode(int value)
@@ -198,6 +264,11 @@ AppState Menu::getCurrentState() const
     return currentState;
 }
 
+Stack &Menu::getStack()
+{
+    return stack;
+}
+
 void Menu::initializeDataStructures()
 {
     linkedList.insert(10);
@@ -206,17 +277,11 @@ void Menu::initializeDataStructures()
     linkedList.insert(40);
     linkedList.insert(50);
 
-    bst.insert(50);
-    bst.insert(30);
-    bst.insert(70);
-    bst.insert(20);
-    bst.insert(40);
+    const int bstValues[] = {50, 30, 70, 20, 40};
+    bst.build_from_unsorted(begin(bstValues), end(bstValues));
 
-    heap.insert(50);
-    heap.insert(30);
-    heap.insert(70);
-    heap.insert(20);
-    heap.insert(40);
+    const int heapValues[] = {50, 30, 70, 20, 40};
+    heap.build(begin(heapValues), end(heapValues));
 
     rbTree.insert(50);
     rbTree.insert(30);
@@ -236,68 +301,392 @@ void Menu::initializeDataStructures()
     queue.enqueue(40);
     queue.enqueue(50);
 
-    pq.enqueue(10);
-    pq.enqueue(20);
-    pq.enqueue(30);
-    pq.enqueue(40);
-    pq.enqueue(50);
+    const int pqValues[] = {10, 20, 30, 40, 50};
+    pq.build(begin(pqValues), end(pqValues));
 }
 
-int main()
+// Options of the headless mode, which renders into an offscreen texture instead of a window
+struct HeadlessOptions
 {
-    sf::RenderWindow window(sf::VideoMode(800, 600), "Data Structures Menu");
+    AppState state = AppState::MainMenu;
+    unsigned int width = 800;
+    unsigned int height = 600;
+    int frames = 1;
+    int nodes = 0;         // Extra random values added to every structure before rendering
+    bool mutate = false;   // Add one more value before each frame, so every frame rebuilds
+    int pngEvery = 1;      // Save every Nth frame, 0 saves none
+    string outputDir = ".";
+};
+
+bool parseStructure(const string &name, AppState &state)
+{
+    const pair<const char *, AppState> names[] = {
+        {"menu", AppState::MainMenu}, {"list", AppState::LinkedList}, {"bst", AppState::BinarySearchTree},
+        {"heap", AppState::Heap}, {"rbtree", AppState::RedBlackTree}, {"stack", AppState::Stack},
+        {"queue", AppState::Queue}, {"pq", AppState::PriorityQueue}};
+    for (const auto &entry : names)
+    {
+        if (name == entry.first)
+        {
+            state = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Render frames of one structure into an sf::RenderTexture, write them out as PNGs
+// and report the render throughput. Needs an OpenGL context but no display, so it
+// also runs under a software GL driver.
+int runHeadless(const HeadlessOptions &options)
+{
+    sf::RenderTexture texture;
+    if (!texture.create(options.width, options.height))
+    {
+        cerr << "Could not create a " << options.width << "x" << options.height << " render texture" << endl;
+        return 1;
+    }
+
     Menu menu;
+    srand(1); // Same values on every run, so exported frames can be compared
+    for (int i = 0; i < options.nodes; ++i)
+    {
+        menu.addNode(rand() % 100000);
+    }
+
+    sf::Clock clock;
+    sf::Time renderTime;
+    sf::Time saveTime;
+    int saved = 0;
+    for (int frame = 0; frame < options.frames; ++frame)
+    {
+        if (options.mutate)
+            menu.addNode(rand() % 100000);
+
+        clock.restart();
+        texture.clear(sf::Color::Black);
+        menu.display(options.state, texture);
+        texture.display();
+        renderTime += clock.getElapsedTime();
+
+        if (options.pngEvery > 0 && frame % options.pngEvery == 0)
+        {
+            clock.restart();
+            char name[32];
+            snprintf(name, sizeof(name), "/frame_%05d.png", frame);
+            if (!texture.getTexture().copyToImage().saveToFile(options.outputDir + name))
+            {
+                cerr << "Could not write " << options.outputDir + name << endl;
+                return 1;
+            }
+            saveTime += clock.getElapsedTime();
+            ++saved;
+        }
+    }
+
+    double seconds = renderTime.asSeconds();
+    cout << options.frames << " frames in " << seconds << " s";
+    if (seconds > 0)
+        cout << " (" << options.frames / seconds << " frames/s, " << seconds * 1000.0 / options.frames << " ms/frame)";
+    cout << endl;
+    if (saved > 0)
+        cout << saved << " PNGs written to " << options.outputDir << " in " << saveTime.asSeconds() << " s" << endl;
+    return 0;
+}
+
+// Stress test for deep trees: count ascending keys turn a BST into a list, which is
+// drawn into an offscreen texture, walked in order, grown where every insert has to
+// walk the whole list, and torn down by destroying the tree. Nothing on the way
+// recurses per level, so this must not crash at any count.
+int runBstStress(size_t count, const HeadlessOptions &options)
+{
+    sf::RenderTexture texture;
+    if (!texture.create(options.width, options.height))
+    {
+        cerr << "Could not create a " << options.width << "x" << options.height << " render texture" << endl;
+        return 1;
+    }
+
+    auto report = [](const string &what, size_t operations, sf::Time time) {
+        cout << "  " << what << ": " << time.asSeconds() * 1000.0 << " ms";
+        if (time > sf::Time::Zero)
+            cout << " (" << operations / time.asSeconds() / 1e6 << " M/s)";
+        cout << endl;
+    };
+    auto draw = [&texture](BST &tree) {
+        texture.clear(sf::Color::Black);
+        tree.visualize(texture);
+        texture.display();
+    };
+
+    cout << count << " ascending keys" << endl;
+    unique_ptr<BST> tree(new BST());
+    sf::Clock clock;
+    for (size_t i = 0; i < count; ++i)
+    {
+        tree->insert(static_cast<int>(i));
+    }
+    report("insert", count, clock.restart());
+
+    draw(*tree); // Lays out the whole list once
+    report("first frame", count, clock.restart());
+
+    bool ok = true;
+    int expected = 0;
+    for (int value : *tree)
+    {
+        ok = ok && value == expected++;
+    }
+    report("walk in order", count, clock.restart());
+    ok = ok && static_cast<size_t>(expected) == count;
+
+    // A copy of the second largest key goes left of the largest, at the very bottom,
+    // so its insert walks the whole list and its redraw relays out every level
+    const int deepInserts = 10;
+    if (count >= 2)
+    {
+        for (int i = 0; i < deepInserts; ++i)
+        {
+            tree->insert(static_cast<int>(count) - 2);
+            draw(*tree);
+        }
+        report("insert at the bottom + frame", static_cast<size_t>(deepInserts) * count, clock.restart());
+    }
+
+    tree.reset();
+    report("tear down", count, clock.restart());
+
+    if (!ok)
+        cerr << "The walk did not return the keys in order" << endl;
+    return ok ? 0 : 1;
+}
+
+// Ingest thread: publishes rate random values per second, in a batch every 10 ms,
+// until running is cleared. A full queue makes it retry rather than drop values.
+void produceValues(SPSCQueue &queue, const std::atomic<bool> &running, unsigned int rate)
+{
+    mt19937 random(7);
+    vector<int> batch(max(rate / 100, 1u));
+    chrono::steady_clock::time_point next = chrono::steady_clock::now();
+    while (running.load(memory_order_relaxed))
+    {
+        for (int &value : batch)
+        {
+            value = static_cast<int>(random() % 1000);
+        }
+
+        size_t sent = 0;
+        while (sent < batch.size() && running.load(memory_order_relaxed))
+        {
+            sent += queue.try_enqueue_range(batch.data() + sent, batch.size() - sent);
+            if (sent < batch.size())
+                this_thread::yield(); // The render loop has not caught up yet
+        }
+
+        next += chrono::milliseconds(10);
+        this_thread::sleep_until(next);
+    }
+}
+
+// Stack worker: pushes and pops random values on a concurrent stack until running is
+// cleared, holding at most a few values of its own so the stack stays on screen
+void stackWorker(Stack &stack, const std::atomic<bool> &running, unsigned int seed)
+{
+    mt19937 random(seed);
+    int held = 0;
+    while (running.load(memory_order_relaxed))
+    {
+        if (held == 0 || (held < 4 && random() % 2 == 0))
+        {
+            stack.push(static_cast<int>(random() % 1000));
+            ++held;
+        }
+        else if (stack.pop())
+        {
+            --held;
+        }
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Idle by default: render on demand and sleep in waitEvent otherwise.
+    // --vsync or --fps N render continuously instead.
+    // --headless <structure> renders offscreen instead of opening a window, see HeadlessOptions.
+    // --bench <name> [--count N] measures a structure core without rendering anything.
+    // --stress-bst N builds, draws and tears down a BST of N ascending keys offscreen.
+    // --ingest N feeds N random values per second to every structure from a producer thread.
+    // --stack-workers N backs the stack with ConcurrentStack and has N threads push and pop on it.
+    FrameScheduler::Mode mode = FrameScheduler::Mode::Idle;
+    unsigned int frameRate = 60;
+    bool headless = false;
+    HeadlessOptions options;
+    string benchmark;
+    size_t benchmarkCount = 1000000;
+    unsigned int ingestRate = 0;
+    unsigned int stackWorkers = 0;
+    size_t stressCount = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--vsync")
+        {
+            mode = FrameScheduler::Mode::VSync;
+        }
+        else if (arg == "--fps" && i + 1 < argc)
+        {
+            mode = FrameScheduler::Mode::FixedRate;
+            frameRate = static_cast<unsigned int>(atoi(argv[++i]));
+        }
+        else if (arg == "--headless" && i + 1 < argc)
+        {
+            headless = true;
+            if (!parseStructure(argv[++i], options.state))
+            {
+                cerr << "Unknown structure " << argv[i] << ", expected menu, list, bst, heap, rbtree, stack, queue or pq" << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--bench" && i + 1 < argc)
+        {
+            benchmark = argv[++i];
+        }
+        else if (arg == "--count" && i + 1 < argc)
+        {
+            benchmarkCount = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--ingest" && i + 1 < argc)
+        {
+            ingestRate = static_cast<unsigned int>(atoi(argv[++i]));
+        }
+        else if (arg == "--stress-bst" && i + 1 < argc)
+        {
+            stressCount = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--stack-workers" && i + 1 < argc)
+        {
+            stackWorkers = static_cast<unsigned int>(atoi(argv[++i]));
+        }
+        else if (arg == "--frames" && i + 1 < argc)
+        {
+            options.frames = atoi(argv[++i]);
+        }
+        else if (arg == "--size" && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%ux%u", &options.width, &options.height) != 2)
+            {
+                cerr << "Expected --size WIDTHxHEIGHT" << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--nodes" && i + 1 < argc)
+        {
+            options.nodes = atoi(argv[++i]);
+        }
+        else if (arg == "--mutate")
+        {
+            options.mutate = true;
+        }
+        else if (arg == "--png-every" && i + 1 < argc)
+        {
+            options.pngEvery = atoi(argv[++i]);
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            options.outputDir = argv[++i];
+        }
+    }
+
+    if (!benchmark.empty())
+        return Benchmark::run(benchmark, benchmarkCount) ? 0 : 1;
+    if (stressCount > 0)
+        return runBstStress(stressCount, options);
+    if (headless)
+        return runHeadless(options);
+
+    // Ingested values and stack workers change things without an input event to wake
+    // the loop, so keep rendering
+    if ((ingestRate > 0 || stackWorkers > 0) && mode == FrameScheduler::Mode::Idle)
+        mode = FrameScheduler::Mode::FixedRate;
+
+    sf::RenderWindow window(sf::VideoMode(800, 600), "Data Structures Menu");
+    FrameScheduler scheduler(window, "Data Structures Menu", mode, frameRate);
+    Menu menu(stackWorkers > 0 ? Stack::Backend::Concurrent : Stack::Backend::Vector);
+    Camera camera(window.getSize());
+
+    SPSCQueue ingest(1 << 16);
+    atomic<bool> ingesting(ingestRate > 0);
+    thread producer;
+    if (ingestRate > 0)
+        producer = thread(produceValues, ref(ingest), cref(ingesting), ingestRate);
+    vector<int> received(ingest.capacity());
+
+    atomic<bool> stacking(stackWorkers > 0);
+    vector<thread> workers;
+    for (unsigned int i = 0; i < stackWorkers; ++i)
+    {
+        workers.emplace_back(stackWorker, ref(menu.getStack()), cref(stacking), 100 + i);
+    }
 
     sf::Event event;
-    bool inputReceived = false;
 
     while (window.isOpen())
     {
-        while (window.pollEvent(event))
+        // Take whatever the ingest thread published since the last frame, without blocking it
+        size_t count = ingest.try_dequeue_n(received.data(), received.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            menu.addNode(received[i]);
+        }
+        if (count > 0)
+            scheduler.requestRedraw();
+
+        while (scheduler.nextEvent(event))
         {
             if (event.type == sf::Event::Closed)
                 window.close();
 
             if (event.type == sf::Event::KeyPressed)
                 menu.handleInput(event.key);
+
+            bool viewChanged = menu.getCurrentState() != AppState::MainMenu && camera.handleEvent(event, window);
+
+            // Plain pointer motion changes nothing on screen; everything else might
+            bool pointerOnly = event.type == sf::Event::MouseMoved || event.type == sf::Event::MouseEntered ||
+                               event.type == sf::Event::MouseLeft;
+            if (viewChanged || !pointerOnly)
+                scheduler.requestRedraw();
         }
 
+        if (!window.isOpen() || !scheduler.shouldRender())
+            continue;
+
+        scheduler.beginFrame();
         window.clear(sf::Color::Black);
 
-        switch (menu.getCurrentState())
-        {
-        case AppState::MainMenu:
-            menu.updateMenu();
-            menu.draw(window);
-            break;
-        case AppState::LinkedList:
-            menu.displayLinkedList(window);
-            break;
-        case AppState::BinarySearchTree:
-            menu.displayBST(window);
-            break;
-        case AppState::Heap:
-            menu.displayHeap(window);
-            break;
-        case AppState::RedBlackTree:
-            menu.displayRedBlackTree(window);
-            break;
-        case AppState::Stack:
-            menu.displayStack(window); // Display Stack
-            break;
-        case AppState::Queue:
-            menu.displayQueue(window); // Display Queue
-            break;
-        case AppState::PriorityQueue:
-            menu.displayPriorityQueue(window); // Display PriorityQueue
-            break;
-        case AppState::Exit:
+        // The menu stays fixed, the structures are seen through the camera
+        if (menu.getCurrentState() == AppState::MainMenu)
+            window.setView(window.getDefaultView());
+        else
+            window.setView(camera.getView());
+
+        if (menu.getCurrentState() == AppState::Exit)
             window.close();
-            break;
-        }
+        else
+            menu.display(menu.getCurrentState(), window);
 
+        scheduler.endFrame();
         window.display();
     }
 
+    ingesting = false;
+    if (producer.joinable())
+        producer.join();
+    stacking = false;
+    for (thread &worker : workers)
+    {
+        worker.join();
+    }
     return 0;
 }